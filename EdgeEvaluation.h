@@ -0,0 +1,16 @@
+#ifndef EDGEEVALUATION_H
+#define EDGEEVALUATION_H
+
+// The collision check and cost of an edge, worked out together by a StateMath's evaluateEdge().
+// collides means the edge can't be traveled, either because it hits an obstacle or because no trajectory exists.
+// cost is INFINITY whenever collides is set, since evaluation stops at the first problem found.
+
+template <class State>
+struct EdgeEvaluation {
+    bool collides;
+    float cost;
+    // dest, with any parameters the cost calculation fills in (see edgeCost's dest_updated)
+    State dest;
+};
+
+#endif
@@ -0,0 +1,34 @@
+#include "OccupancyBitmap.h"
+#include <cstdlib>
+
+OccupancyBitmap::OccupancyBitmap(int _width, int _height) {
+    width = _width;
+    height = _height;
+    tiles_wide = (width + 7) / 8;
+    tiles_high = (height + 7) / 8;
+    tiles = (uint64_t*)calloc(tiles_wide * tiles_high, sizeof(uint64_t));
+}
+
+// uses tiles laid out by another bitmap, such as one saved in a file, without copying or freeing them
+OccupancyBitmap::OccupancyBitmap(int _width, int _height, uint64_t* _tiles) {
+    width = _width;
+    height = _height;
+    tiles_wide = (width + 7) / 8;
+    tiles_high = (height + 7) / 8;
+    tiles = _tiles;
+    owns_tiles = false;
+}
+
+OccupancyBitmap::~OccupancyBitmap() {
+    if (owns_tiles) free(tiles);
+}
+
+void OccupancyBitmap::set(int x, int y, bool occupied) {
+    if (x < 0 || x >= width || y < 0 || y >= height) return;
+    uint64_t bit = (uint64_t)1 << bitoffset(x, y);
+    if (occupied) {
+        tiles[tileoffset(x, y)] |= bit;
+    } else {
+        tiles[tileoffset(x, y)] &= ~bit;
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef OCCUPANCYBITMAP_H
+#define OCCUPANCYBITMAP_H
+
+#include <cstdint>
+
+// One bit per pixel obstacle map, for collision queries on the png based maps.
+// Pixels are stored in 8x8 tiles, one 64 bit word per tile, so pixels that are close in both x and y share a cache line.
+// Anything outside the bitmap counts as an obstacle.
+
+class OccupancyBitmap {
+
+public:
+    OccupancyBitmap(int _width, int _height);
+    OccupancyBitmap(int _width, int _height, uint64_t* _tiles);
+    ~OccupancyBitmap();
+    void set(int x, int y, bool occupied);
+    inline bool get(int x, int y) {
+        if (x < 0 || x >= width || y < 0 || y >= height) return true;
+        return (tiles[tileoffset(x, y)] >> bitoffset(x, y)) & 1;
+    }
+    inline uint64_t* getTiles() { return tiles; }
+    inline int getTileCount() { return tiles_wide * tiles_high; }
+    static int tileCount(int _width, int _height) { return ((_width + 7) / 8) * ((_height + 7) / 8); }
+
+private:
+    inline int tileoffset(int x, int y) { return (y >> 3) * tiles_wide + (x >> 3); }
+    inline int bitoffset(int x, int y) { return ((y & 7) << 3) | (x & 7); }
+
+    int width = 0;
+    int height = 0;
+    int tiles_wide = 0;
+    int tiles_high = 0;
+    uint64_t* tiles = nullptr;
+    bool owns_tiles = true;
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define RRT_CPP
 
 #include "RRT.h"
+#include <iostream>
 
 template<class State, class StateMath, class Map>
 RRT<State, StateMath, Map>::RRT(Map *_map, StateMath *_state_math) {
@@ -35,9 +36,17 @@ void RRT<State, StateMath, Map>::run() {
     }
 
     if (rewiring_enabled) {
-        for (int i=0; i<rewiring_passes; i++) {
-            rewireAll();
-            debugOutputRewire(i);
+        if (rewiring_propagation_enabled) {
+            rewirePropagate();
+            debugOutputRewire(0);
+        } else {
+            for (int i=0; i<rewiring_passes; i++) {
+                rewireAll();
+                debugOutputRewire(i);
+            }
+        }
+        if (rewire_output_enabled) {
+            std::cout << "Rewire: " << edge_cost_evaluations << " edgeCost evaluations, " << edge_obstacle_evaluations << " edgeInObstacle evaluations" << std::endl;
         }
     }
 
@@ -2,11 +2,17 @@
 #define RRT_H
 
 #include "RRTGraph.h"
+#include "EdgeEvaluation.h"
 #include <string>
+#include <vector>
+#include <queue>
+#include <utility>
+#include <functional>
 #include <cmath>
 
 const float GOAL_THRESHOLD_PERCENT_DEFAULT = 0.01f;
 const float NEIGHBORHOOD_THRESHOLD_PERCENT_DEFAULT = 0.01f;
+const float REWIRE_K_SCALE_DEFAULT = 2 * M_E;
 
 template <class State, class StateMath, class Map>
 class RRT {
@@ -15,26 +21,37 @@ public:
     RRT(Map* _map, StateMath* _state_math);
     void setStartState(State* state);
     void setGoalState(State* state, float _goal_threshold_percent);
-    void configureSampling(int _passes, bool _allow_costly_nodes);
+    void configureSampling(int _passes, bool _allow_costly_nodes, int _max_attempts=0);
     void configureRewiring(bool _enabled, float _neighborhood_threshold_percent, int _passes);
+    void configureIncrementalRewiring(bool _enabled, float _k_scale);
+    void configureRewiringPropagation(bool _enabled);
     void configureDebugOutput(bool _sampling, bool _rewire, std::string _filename_prefix, int width, int height);
     void run();
     void initRandomSamples();
-    void addRandomSample();
+    bool addRandomSample();
     void renderVis();
     void clearDebugBuffer();
     void addDebugText(std::string text);
     std::string getDebugText();
     float getGoalCost();
+    bool getGoalPath(std::vector<State>* path);
+    void setCostBound(float cost);
     void rewireAll();
+    void rewirePropagate();
+    void getRewireStats(long* _edge_cost_evaluations, long* _edge_obstacle_evaluations);
 
 private:
     Node<State>* getNearestNode(State* state);
+    void getNearestNodes(State* state, int count, std::vector<Node<State>*>* nearest);
+    void choose_parent(State* candidate, std::vector<Node<State>*>* neighbors, Node<State>** parent, float* cost, State* candidate_from_edge_calc);
+    void rewire_neighbors(Node<State>* newnode, std::vector<Node<State>*>* neighbors);
     float calc_goal_distance_threshold();
     float calc_neighborhood_distance_threshold();
-    void delete_high_cost_nodes(float cost_threshold);
+    void prune_nodes(float cost_threshold);
     void rewireNode(Node<State>* target);
     void apply_cost_delta_recursive(Node<State>* node, float cost_delta);
+    void rewire_propagate_from(Node<State>* source);
+    void rewire_push_subtree(Node<State>* root);
     void debugOutputSample(int iteration);
     void debugOutputRewire(int iteration);
 
@@ -52,12 +69,28 @@ private:
 
     bool allow_costly_nodes = false;
 
+    // best goal cost known from outside this tree, e.g. shared by other planners in a portfolio
+    float cost_bound = INFINITY;
+
+    // every node, keyed by cost + costToGo at the time it was queued, least promising on top
+    std::priority_queue<std::pair<float, Node<State>*>> prune_queue;
+
     int sampling_passes = 1;
+    int sampling_max_attempts = 0;
 
     bool rewiring_enabled = false;
     float rewiring_neighbor_threshold = NEIGHBORHOOD_THRESHOLD_PERCENT_DEFAULT;
     int rewiring_passes = 1;
 
+    bool incremental_rewiring_enabled = false;
+    float incremental_rewiring_k_scale = REWIRE_K_SCALE_DEFAULT;
+
+    bool rewiring_propagation_enabled = false;
+    std::priority_queue<std::pair<float, Node<State>*>, std::vector<std::pair<float, Node<State>*>>, std::greater<std::pair<float, Node<State>*>>> rewire_queue;
+
+    long edge_cost_evaluations = 0;
+    long edge_obstacle_evaluations = 0;
+
     float goal_threshold_percent = GOAL_THRESHOLD_PERCENT_DEFAULT;
 
     bool sampling_output_enabled = false;
@@ -21,7 +21,7 @@ RRTGraph<State>::~RRTGraph() {
 template<class State>
 Node<State> *RRTGraph<State>::addNode(State *_state, Node<State> *_parent, float _cost) {
     Node<State>* output = addNode(_state);
-    output->parent = _parent;
+    setParent(output, _parent);
     output->cost = _cost;
     return output;
 }
@@ -38,6 +38,10 @@ Node<State>* RRTGraph<State>::addNode(State* _state) {
     nodes[nodes_next_index].parent = nullptr;
     nodes[nodes_next_index].next = nullptr;
     nodes[nodes_next_index].prev = node_last;
+    nodes[nodes_next_index].first_child = nullptr;
+    nodes[nodes_next_index].next_sibling = nullptr;
+    nodes[nodes_next_index].prev_sibling = nullptr;
+    nodes[nodes_next_index].deleted = false;
     if (node_first == nullptr) {
         node_first = &nodes[nodes_next_index];
     }
@@ -51,13 +55,10 @@ Node<State>* RRTGraph<State>::addNode(State* _state) {
 
 template <class State>
 void RRTGraph<State>::delNode(Node<State>* node) {
-    Node<State>* node_i = first();
-    while (node_i != nullptr) {
-        if (node_i->parent == node) {
-            delNode(node_i);
-        }
-        node_i = node_i->next;
+    while (node->first_child != nullptr) {
+        delNode(node->first_child);
     }
+    setParent(node, nullptr);
     if (node->next != nullptr) {
         node->next->prev = node->prev;
     }
@@ -67,9 +68,38 @@ void RRTGraph<State>::delNode(Node<State>* node) {
     if (node == node_first) {
         node_first = node->next;
     }
+    if (node == node_last) {
+        node_last = node->prev;
+    }
+    node->deleted = true;
     nodes_size--;
 }
 
+// moves node (and its subtree) under a new parent, keeping the child lists in sync.  parent can be nullptr.
+template <class State>
+void RRTGraph<State>::setParent(Node<State>* node, Node<State>* parent) {
+    if (node->parent != nullptr) {
+        if (node->prev_sibling != nullptr) {
+            node->prev_sibling->next_sibling = node->next_sibling;
+        } else {
+            node->parent->first_child = node->next_sibling;
+        }
+        if (node->next_sibling != nullptr) {
+            node->next_sibling->prev_sibling = node->prev_sibling;
+        }
+    }
+    node->parent = parent;
+    node->prev_sibling = nullptr;
+    node->next_sibling = nullptr;
+    if (parent != nullptr) {
+        node->next_sibling = parent->first_child;
+        if (parent->first_child != nullptr) {
+            parent->first_child->prev_sibling = node;
+        }
+        parent->first_child = node;
+    }
+}
+
 template<class State>
 Node<State> *RRTGraph<State>::atIndex(int _index) {
     return &nodes[_index];
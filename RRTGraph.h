@@ -15,6 +15,12 @@ public:
     Node* parent;
     Node* next;
     Node* prev;
+    // children of a node form a doubly linked list through the sibling pointers
+    Node* first_child;
+    Node* next_sibling;
+    Node* prev_sibling;
+    // set once the node is removed from the graph.  storage isn't reused, so stale pointers can check this.
+    bool deleted;
 };
 
 template <class State>
@@ -26,6 +32,7 @@ public:
     Node<State>* addNode(State* _state);
     Node<State>* addNode(State* _state, Node<State>* _parent, float _cost);
     void delNode(Node<State>*);
+    void setParent(Node<State>* node, Node<State>* parent);
     Node<State>* atIndex(int _index);
     Node<State>* first();
     Node<State>* find(State* _state);
@@ -0,0 +1,363 @@
+#ifndef RRTPARTITIONED2D_CPP
+#define RRTPARTITIONED2D_CPP
+
+#include "RRTPartitioned2D.h"
+#include "utils.h"
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <iostream>
+#include <algorithm>
+
+template<class StateMath>
+RRTPartitioned2D<StateMath>::RRTPartitioned2D(Map2D *_map, StateMath *_state_math) {
+    map = _map;
+    state_math = _state_math;
+    state_math->setMap(map);
+}
+
+template<class StateMath>
+void RRTPartitioned2D<StateMath>::setStartState(State2D *state) {
+    start = *state;
+}
+
+template<class StateMath>
+void RRTPartitioned2D<StateMath>::setGoalState(State2D *state, float _goal_threshold_percent) {
+    goal = *state;
+    goal_threshold_percent = _goal_threshold_percent;
+}
+
+// the map is split into a _columns x _rows grid of regions, with up to _portals_per_boundary portals on each
+// boundary between neighboring regions.  at most _max_workers worker processes run at the same time.
+template<class StateMath>
+void RRTPartitioned2D<StateMath>::configurePartition(int _columns, int _rows, int _portals_per_boundary, int _max_workers) {
+    columns = _columns;
+    rows = _rows;
+    portals_per_boundary = _portals_per_boundary;
+    max_workers = _max_workers;
+}
+
+// sampling and rewiring settings apply to every local tree, so _passes is per portal pair, not for the whole map
+template<class StateMath>
+void RRTPartitioned2D<StateMath>::configureSampling(int _passes, bool _allow_costly_nodes) {
+    sampling_passes = _passes;
+    allow_costly_nodes = _allow_costly_nodes;
+}
+
+template<class StateMath>
+void RRTPartitioned2D<StateMath>::configureRewiring(bool _enabled, float _neighborhood_threshold_percent, int _passes) {
+    rewiring_enabled = _enabled;
+    rewiring_neighbor_threshold = _neighborhood_threshold_percent;
+    rewiring_passes = _passes;
+}
+
+template<class StateMath>
+void RRTPartitioned2D<StateMath>::configureDebugOutput(std::string _filename_prefix) {
+    debug_output_prefix = _filename_prefix;
+    mkpath(debug_output_prefix.c_str(), S_IRWXU);
+}
+
+template<class StateMath>
+void RRTPartitioned2D<StateMath>::run() {
+    segments.clear();
+    make_regions();
+    make_portals();
+
+    std::vector<int> fds;
+    std::vector<pid_t> pids;
+    for (int region = 0; region < (int)region_min.size(); region++) {
+        if ((int)fds.size() == max_workers) {
+            read_segments(fds.front());
+            waitpid(pids.front(), nullptr, 0);
+            fds.erase(fds.begin());
+            pids.erase(pids.begin());
+        }
+        pid_t pid;
+        int fd = spawn_worker(region, &pid);
+        if (fd == -1) continue;
+        fds.push_back(fd);
+        pids.push_back(pid);
+    }
+    for (int i = 0; i < (int)fds.size(); i++) {
+        read_segments(fds[i]);
+        waitpid(pids[i], nullptr, 0);
+    }
+
+    stitch_path();
+
+    if (!debug_output_prefix.empty()) {
+        render_vis();
+    }
+}
+
+///////////////////////////////////////////////  PARTITIONING  ///////////////////////////////////////////////
+
+template<class StateMath>
+void RRTPartitioned2D<StateMath>::make_regions() {
+    State2D minimums, maximums;
+    map->getBounds(&minimums, &maximums);
+    double width = maximums.x - minimums.x;
+    double height = maximums.y - minimums.y;
+
+    region_min.clear();
+    region_max.clear();
+    for (int row = 0; row < rows; row++) {
+        for (int column = 0; column < columns; column++) {
+            region_min.push_back(State2D(minimums.x + width * column / columns, minimums.y + height * row / rows));
+            region_max.push_back(State2D(minimums.x + width * (column + 1) / columns, minimums.y + height * (row + 1) / rows));
+        }
+    }
+
+    waypoints.clear();
+    region_waypoints.assign(region_min.size(), std::vector<int>());
+    waypoints.push_back(start);
+    region_waypoints[region_at(&start)].push_back(0);
+    waypoints.push_back(goal);
+    region_waypoints[region_at(&goal)].push_back(1);
+}
+
+// spread portals evenly along every shared boundary.  each portal gets its own slot of the boundary, and moves to the
+// free pixel closest to the middle of its slot.  slots that are completely blocked don't get a portal.
+template<class StateMath>
+void RRTPartitioned2D<StateMath>::make_portals() {
+    for (int row = 0; row < rows; row++) {
+        for (int column = 0; column < columns; column++) {
+            int region = row * columns + column;
+
+            if (column + 1 < columns) {
+                double x = region_max[region].x;
+                double y0 = region_min[region].y;
+                double slot = (region_max[region].y - y0) / portals_per_boundary;
+                for (int k = 0; k < portals_per_boundary; k++) {
+                    for (double offset = 0; offset < slot / 2; offset++) {
+                        State2D above(x, y0 + slot * (k + 0.5) - offset);
+                        State2D below(x, y0 + slot * (k + 0.5) + offset);
+                        if (!state_math->pointInObstacle(&above)) { add_portal(&above, region, region + 1); break; }
+                        if (!state_math->pointInObstacle(&below)) { add_portal(&below, region, region + 1); break; }
+                    }
+                }
+            }
+
+            if (row + 1 < rows) {
+                double y = region_max[region].y;
+                double x0 = region_min[region].x;
+                double slot = (region_max[region].x - x0) / portals_per_boundary;
+                for (int k = 0; k < portals_per_boundary; k++) {
+                    for (double offset = 0; offset < slot / 2; offset++) {
+                        State2D left(x0 + slot * (k + 0.5) - offset, y);
+                        State2D right(x0 + slot * (k + 0.5) + offset, y);
+                        if (!state_math->pointInObstacle(&left)) { add_portal(&left, region, region + columns); break; }
+                        if (!state_math->pointInObstacle(&right)) { add_portal(&right, region, region + columns); break; }
+                    }
+                }
+            }
+        }
+    }
+}
+
+template<class StateMath>
+void RRTPartitioned2D<StateMath>::add_portal(State2D *point, int region_a, int region_b) {
+    waypoints.push_back(*point);
+    region_waypoints[region_a].push_back(waypoints.size() - 1);
+    region_waypoints[region_b].push_back(waypoints.size() - 1);
+}
+
+template<class StateMath>
+int RRTPartitioned2D<StateMath>::region_at(State2D *point) {
+    State2D minimums, maximums;
+    map->getBounds(&minimums, &maximums);
+    int column = (point->x - minimums.x) / (maximums.x - minimums.x) * columns;
+    int row = (point->y - minimums.y) / (maximums.y - minimums.y) * rows;
+    column = max(0, min(column, columns - 1));
+    row = max(0, min(row, rows - 1));
+    return row * columns + column;
+}
+
+/////////////////////////////////////////////////  WORKERS  /////////////////////////////////////////////////
+
+// forks a worker for one region.  returns the coordinator's end of the socket the worker streams its segments into.
+template<class StateMath>
+int RRTPartitioned2D<StateMath>::spawn_worker(int region, pid_t* pid) {
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+        std::cerr << "RRTPartitioned2D: socketpair() failed for region " << region << std::endl;
+        return -1;
+    }
+
+    *pid = fork();
+    if (*pid == -1) {
+        std::cerr << "RRTPartitioned2D: fork() failed for region " << region << std::endl;
+        close(sockets[0]);
+        close(sockets[1]);
+        return -1;
+    }
+
+    if (*pid == 0) {
+        close(sockets[0]);
+        run_worker(region, sockets[1]);
+        close(sockets[1]);
+        _exit(0);
+    }
+
+    close(sockets[1]);
+    return sockets[0];
+}
+
+template<class StateMath>
+void RRTPartitioned2D<StateMath>::run_worker(int region, int fd) {
+    std::vector<int>& local = region_waypoints[region];
+    for (int i = 0; i < (int)local.size(); i++) {
+        for (int j = i + 1; j < (int)local.size(); j++) {
+            RRTPartitionedSegment segment;
+            plan_segment(region, local[i], local[j], &segment);
+            if (segment.cost == INFINITY) continue;
+
+            RRTPartitionedSegmentHeader header{segment.waypoint_a, segment.waypoint_b, segment.cost, (int)segment.path.size()};
+            if (!write_all(fd, &header, sizeof(header))) return;
+            if (!write_all(fd, segment.path.data(), sizeof(State2D) * segment.path.size())) return;
+        }
+    }
+}
+
+// grow a tree from one waypoint to another, with samples confined to the region
+template<class StateMath>
+void RRTPartitioned2D<StateMath>::plan_segment(int region, int waypoint_a, int waypoint_b, RRTPartitionedSegment *segment) {
+    RRT<State2D,StateMath,Map2D>* rrt = new RRT<State2D,StateMath,Map2D>(map, state_math);
+    state_math->setRandomStateConstraints(region_min[region], region_max[region]);
+    state_math->setRandomSeed(waypoint_a * waypoints.size() + waypoint_b + 1);
+
+    rrt->setStartState(&waypoints[waypoint_a]);
+    rrt->setGoalState(&waypoints[waypoint_b], goal_threshold_percent);
+    rrt->configureSampling(sampling_passes, allow_costly_nodes, PARTITION_MAX_SAMPLE_ATTEMPTS);
+    rrt->configureRewiring(rewiring_enabled, rewiring_neighbor_threshold, rewiring_passes);
+    rrt->initRandomSamples();
+    for (int i = 0; i < sampling_passes; i++) {
+        if (!rrt->addRandomSample()) break;
+    }
+    if (rewiring_enabled) {
+        for (int i = 0; i < rewiring_passes; i++) {
+            rrt->rewireAll();
+        }
+    }
+
+    segment->waypoint_a = waypoint_a;
+    segment->waypoint_b = waypoint_b;
+    segment->cost = rrt->getGoalCost();
+    rrt->getGoalPath(&segment->path);
+    delete rrt;
+}
+
+template<class StateMath>
+void RRTPartitioned2D<StateMath>::read_segments(int fd) {
+    RRTPartitionedSegmentHeader header;
+    while (read_all(fd, &header, sizeof(header))) {
+        RRTPartitionedSegment segment;
+        segment.waypoint_a = header.waypoint_a;
+        segment.waypoint_b = header.waypoint_b;
+        segment.cost = header.cost;
+        segment.path.resize(header.state_count);
+        if (!read_all(fd, segment.path.data(), sizeof(State2D) * header.state_count)) break;
+        segments.push_back(segment);
+    }
+    close(fd);
+}
+
+template<class StateMath>
+bool RRTPartitioned2D<StateMath>::write_all(int fd, const void *data, size_t size) {
+    const char* bytes = (const char*)data;
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if (written <= 0) return false;
+        bytes += written;
+        size -= written;
+    }
+    return true;
+}
+
+template<class StateMath>
+bool RRTPartitioned2D<StateMath>::read_all(int fd, void *data, size_t size) {
+    char* bytes = (char*)data;
+    while (size > 0) {
+        ssize_t got = read(fd, bytes, size);
+        if (got <= 0) return false;
+        bytes += got;
+        size -= got;
+    }
+    return true;
+}
+
+/////////////////////////////////////////////////  STITCHING  ////////////////////////////////////////////////
+
+// dijkstra over the waypoint graph, where every segment found by a worker is an edge usable in both directions
+template<class StateMath>
+void RRTPartitioned2D<StateMath>::stitch_path() {
+    int count = waypoints.size();
+    std::vector<float> cost(count, INFINITY);
+    std::vector<int> via_segment(count, -1);
+    std::vector<bool> done(count, false);
+    cost[0] = 0;
+
+    while (true) {
+        int current = -1;
+        for (int i = 0; i < count; i++) {
+            if (!done[i] && cost[i] < INFINITY && (current == -1 || cost[i] < cost[current])) current = i;
+        }
+        if (current == -1 || current == 1) break;
+        done[current] = true;
+
+        for (int s = 0; s < (int)segments.size(); s++) {
+            int other = segments[s].waypoint_a == current ? segments[s].waypoint_b
+                      : segments[s].waypoint_b == current ? segments[s].waypoint_a : -1;
+            if (other == -1 || done[other]) continue;
+            float new_cost = cost[current] + segments[s].cost;
+            if (new_cost < cost[other]) {
+                cost[other] = new_cost;
+                via_segment[other] = s;
+            }
+        }
+    }
+
+    goal_cost = cost[1];
+    goal_path.clear();
+    if (goal_cost == INFINITY) return;
+
+    for (int waypoint = 1; waypoint != 0; ) {
+        RRTPartitionedSegment& segment = segments[via_segment[waypoint]];
+        bool forward = segment.waypoint_b == waypoint;
+        std::vector<State2D> piece = segment.path;
+        if (!forward) std::reverse(piece.begin(), piece.end());
+        if (!goal_path.empty()) piece.pop_back();
+        goal_path.insert(goal_path.begin(), piece.begin(), piece.end());
+        waypoint = forward ? segment.waypoint_a : segment.waypoint_b;
+    }
+}
+
+template<class StateMath>
+void RRTPartitioned2D<StateMath>::render_vis() {
+    map->resetVis();
+    for (RRTPartitionedSegment& segment : segments) {
+        for (int i = 1; i < (int)segment.path.size(); i++) {
+            map->addVisLine(&segment.path[i-1], &segment.path[i], 0x00999999);
+        }
+    }
+    for (State2D& waypoint : waypoints) {
+        map->addVisPoint(&waypoint, 0x00006600, true);
+    }
+    for (int i = 1; i < (int)goal_path.size(); i++) {
+        map->addVisLine(&goal_path[i-1], &goal_path[i], 0x00ff0000);
+    }
+    map->renderVis(debug_output_prefix + "/partitioned");
+}
+
+template<class StateMath>
+float RRTPartitioned2D<StateMath>::getGoalCost() {
+    return goal_cost;
+}
+
+template<class StateMath>
+bool RRTPartitioned2D<StateMath>::getGoalPath(std::vector<State2D> *path) {
+    *path = goal_path;
+    return !goal_path.empty();
+}
+
+#endif
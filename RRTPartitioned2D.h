@@ -0,0 +1,100 @@
+#ifndef RRTPARTITIONED2D_H
+#define RRTPARTITIONED2D_H
+
+#include "RRT.h"
+#include "statespace/2d/State2D.h"
+#include "statespace/2d/Map2D.h"
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+// Plans on very large 2d maps by splitting the map into a grid of regions, each handled by its own worker process.
+// Neighboring regions share "portals", free points spread along their common boundary.  Each worker grows local trees,
+// with sampling confined to its region, between every pair of portals (plus start and goal) inside its region, and
+// streams the resulting segments back to the coordinator over a unix socket.  The coordinator then runs a shortest
+// path search over the portal graph and stitches the chosen segments into one global path.
+// Workers are forked, so they share the already loaded map with the coordinator without copying it.
+
+// local trees give up on a sample after this many tries, since a region can cut a waypoint off from the rest of it
+const int PARTITION_MAX_SAMPLE_ATTEMPTS = 1000;
+
+struct RRTPartitionedSegmentHeader {
+    int waypoint_a;
+    int waypoint_b;
+    float cost;
+    int state_count;
+};
+
+struct RRTPartitionedSegment {
+    int waypoint_a;
+    int waypoint_b;
+    float cost;
+    std::vector<State2D> path;
+};
+
+template <class StateMath>
+class RRTPartitioned2D {
+
+public:
+    RRTPartitioned2D(Map2D* _map, StateMath* _state_math);
+    void setStartState(State2D* state);
+    void setGoalState(State2D* state, float _goal_threshold_percent);
+    void configurePartition(int _columns, int _rows, int _portals_per_boundary, int _max_workers);
+    void configureSampling(int _passes, bool _allow_costly_nodes);
+    void configureRewiring(bool _enabled, float _neighborhood_threshold_percent, int _passes);
+    void configureDebugOutput(std::string _filename_prefix);
+    void run();
+    float getGoalCost();
+    bool getGoalPath(std::vector<State2D>* path);
+
+private:
+    void make_regions();
+    void make_portals();
+    void add_portal(State2D* point, int region_a, int region_b);
+    int region_at(State2D* point);
+    int spawn_worker(int region, pid_t* pid);
+    void run_worker(int region, int fd);
+    void plan_segment(int region, int waypoint_a, int waypoint_b, RRTPartitionedSegment* segment);
+    void read_segments(int fd);
+    void stitch_path();
+    void render_vis();
+    static bool write_all(int fd, const void* data, size_t size);
+    static bool read_all(int fd, void* data, size_t size);
+
+    Map2D* map = nullptr;
+    StateMath* state_math = nullptr;
+
+    State2D start, goal;
+    float goal_threshold_percent = GOAL_THRESHOLD_PERCENT_DEFAULT;
+
+    int columns = 1;
+    int rows = 1;
+    int portals_per_boundary = 1;
+    int max_workers = 1;
+
+    int sampling_passes = 1;
+    bool allow_costly_nodes = false;
+    bool rewiring_enabled = false;
+    float rewiring_neighbor_threshold = NEIGHBORHOOD_THRESHOLD_PERCENT_DEFAULT;
+    int rewiring_passes = 1;
+
+    // regions[i] spans [region_min[i], region_max[i]]
+    std::vector<State2D> region_min;
+    std::vector<State2D> region_max;
+
+    // waypoint 0 is the start, 1 is the goal, the rest are portals.
+    // each waypoint belongs to one region (start, goal) or two regions (portals).
+    std::vector<State2D> waypoints;
+    std::vector<std::vector<int>> region_waypoints;
+
+    std::vector<RRTPartitionedSegment> segments;
+
+    float goal_cost = INFINITY;
+    std::vector<State2D> goal_path;
+
+    std::string debug_output_prefix = "";
+};
+
+#include "RRTPartitioned2D.cpp"
+
+#endif
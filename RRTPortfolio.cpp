@@ -0,0 +1,163 @@
+#ifndef RRTPORTFOLIO_CPP
+#define RRTPORTFOLIO_CPP
+
+#include "RRTPortfolio.h"
+#include "utils.h"
+#include <thread>
+
+template<class State, class StateMath, class Map>
+RRTPortfolio<State, StateMath, Map>::RRTPortfolio(Map *_map, std::vector<StateMath*> _state_maths) {
+    map = _map;
+    best_cost = INFINITY;
+    stop = false;
+    for (int i=0; i<(int)_state_maths.size(); i++) {
+        _state_maths[i]->setRandomSeed(i + 1);
+        instances.push_back(new RRT<State,StateMath,Map>(map, _state_maths[i]));
+    }
+}
+
+template<class State, class StateMath, class Map>
+RRTPortfolio<State, StateMath, Map>::~RRTPortfolio() {
+    for (RRT<State,StateMath,Map>* instance : instances) {
+        delete instance;
+    }
+}
+
+template<class State, class StateMath, class Map>
+void RRTPortfolio<State, StateMath, Map>::setStartState(State *state) {
+    for (RRT<State,StateMath,Map>* instance : instances) {
+        instance->setStartState(state);
+    }
+}
+
+template<class State, class StateMath, class Map>
+void RRTPortfolio<State, StateMath, Map>::setGoalState(State *state, float _goal_threshold_percent) {
+    for (RRT<State,StateMath,Map>* instance : instances) {
+        instance->setGoalState(state, _goal_threshold_percent);
+    }
+}
+
+template<class State, class StateMath, class Map>
+void RRTPortfolio<State, StateMath, Map>::configureSampling(int _passes, bool _allow_costly_nodes) {
+    sampling_passes = _passes;
+    for (RRT<State,StateMath,Map>* instance : instances) {
+        instance->configureSampling(_passes, _allow_costly_nodes);
+    }
+}
+
+template<class State, class StateMath, class Map>
+void RRTPortfolio<State, StateMath, Map>::configureRewiring(bool _enabled, float _neighborhood_threshold_percent, int _passes) {
+    rewiring_enabled = _enabled;
+    rewiring_passes = _passes;
+    for (RRT<State,StateMath,Map>* instance : instances) {
+        instance->configureRewiring(_enabled, _neighborhood_threshold_percent, _passes);
+    }
+}
+
+// target_cost: stop all instances once any of them finds a path at or below this cost.
+// INFINITY stops at the first path found by any instance.
+// broadcast_interval: number of samples between checks for a better goal cost from the other instances.
+template<class State, class StateMath, class Map>
+void RRTPortfolio<State, StateMath, Map>::configurePortfolio(float _target_cost, int _broadcast_interval) {
+    target_cost = _target_cost;
+    broadcast_interval = _broadcast_interval;
+}
+
+// the map's vis buffers can't be shared between threads, so only the winning tree is rendered, after all instances finish
+template<class State, class StateMath, class Map>
+void RRTPortfolio<State, StateMath, Map>::configureDebugOutput(std::string _filename_prefix) {
+    debug_output_prefix = _filename_prefix;
+    mkpath(debug_output_prefix.c_str(), S_IRWXU);
+}
+
+template<class State, class StateMath, class Map>
+void RRTPortfolio<State, StateMath, Map>::run() {
+    best_cost = INFINITY;
+    stop = false;
+
+    std::vector<std::thread> threads;
+    for (int i=0; i<(int)instances.size(); i++) {
+        threads.push_back(std::thread(&RRTPortfolio<State,StateMath,Map>::run_instance, this, i));
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    if (!debug_output_prefix.empty() && best_instance != -1) {
+        instances[best_instance]->renderVis();
+        map->renderVis(debug_output_prefix + "/portfolio");
+    }
+}
+
+template<class State, class StateMath, class Map>
+void RRTPortfolio<State, StateMath, Map>::run_instance(int index) {
+    RRT<State,StateMath,Map>* instance = instances[index];
+
+    instance->initRandomSamples();
+
+    for (int i=0; i<sampling_passes && !stop; i++) {
+        instance->addRandomSample();
+        publish(index);
+        if (i % broadcast_interval == 0) {
+            receive(index);
+        }
+    }
+
+    if (rewiring_enabled) {
+        for (int i=0; i<rewiring_passes && !stop; i++) {
+            receive(index);
+            instance->rewireAll();
+            publish(index);
+        }
+    }
+}
+
+// share this instance's goal cost with the portfolio if it is the best so far
+template<class State, class StateMath, class Map>
+void RRTPortfolio<State, StateMath, Map>::publish(int index) {
+    float cost = instances[index]->getGoalCost();
+    if (cost >= best_cost) return;
+
+    std::lock_guard<std::mutex> lock(best_mutex);
+    if (cost < best_cost) {
+        best_cost = cost;
+        best_instance = index;
+        instances[index]->getGoalPath(&best_path);
+        if (target_reached()) {
+            stop = true;
+        }
+    }
+}
+
+// prune this instance's tree against the best goal cost found by any instance
+template<class State, class StateMath, class Map>
+void RRTPortfolio<State, StateMath, Map>::receive(int index) {
+    float cost = best_cost;
+    if (cost < instances[index]->getGoalCost()) {
+        instances[index]->setCostBound(cost);
+    }
+}
+
+template<class State, class StateMath, class Map>
+bool RRTPortfolio<State, StateMath, Map>::target_reached() {
+    return best_cost < INFINITY && best_cost <= target_cost;
+}
+
+template<class State, class StateMath, class Map>
+float RRTPortfolio<State, StateMath, Map>::getGoalCost() {
+    return best_cost;
+}
+
+template<class State, class StateMath, class Map>
+bool RRTPortfolio<State, StateMath, Map>::getGoalPath(std::vector<State> *path) {
+    std::lock_guard<std::mutex> lock(best_mutex);
+    *path = best_path;
+    return !best_path.empty();
+}
+
+template<class State, class StateMath, class Map>
+int RRTPortfolio<State, StateMath, Map>::getBestInstance() {
+    return best_instance;
+}
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef RRTPORTFOLIO_H
+#define RRTPORTFOLIO_H
+
+#include "RRT.h"
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+
+const int PORTFOLIO_BROADCAST_INTERVAL_DEFAULT = 100;
+
+// Runs several independently seeded RRT instances against one shared map, one thread per instance.
+// Instances periodically pick up the best goal cost found by any of them and prune their trees against it,
+// and the whole portfolio stops as soon as one instance reaches the target cost.
+// Each instance needs its own StateMath, since sampling and edge evaluation keep per-instance state.
+
+template <class State, class StateMath, class Map>
+class RRTPortfolio {
+
+public:
+    RRTPortfolio(Map* _map, std::vector<StateMath*> _state_maths);
+    ~RRTPortfolio();
+    void setStartState(State* state);
+    void setGoalState(State* state, float _goal_threshold_percent);
+    void configureSampling(int _passes, bool _allow_costly_nodes);
+    void configureRewiring(bool _enabled, float _neighborhood_threshold_percent, int _passes);
+    void configurePortfolio(float _target_cost, int _broadcast_interval);
+    void configureDebugOutput(std::string _filename_prefix);
+    void run();
+    float getGoalCost();
+    bool getGoalPath(std::vector<State>* path);
+    int getBestInstance();
+
+private:
+    void run_instance(int index);
+    void publish(int index);
+    void receive(int index);
+    bool target_reached();
+
+    Map* map = nullptr;
+    std::vector<RRT<State,StateMath,Map>*> instances;
+
+    int sampling_passes = 1;
+    bool rewiring_enabled = false;
+    int rewiring_passes = 1;
+
+    float target_cost = 0;
+    int broadcast_interval = PORTFOLIO_BROADCAST_INTERVAL_DEFAULT;
+
+    std::atomic<float> best_cost;
+    std::atomic<bool> stop;
+    std::mutex best_mutex;
+    std::vector<State> best_path;
+    int best_instance = -1;
+
+    std::string debug_output_prefix = "";
+};
+
+#include "RRTPortfolio.cpp"
+
+#endif
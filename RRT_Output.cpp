@@ -70,6 +70,17 @@ float RRT<State, StateMath, Map>::getGoalCost() {
     return goal.cost;
 }
 
+// fills path with the states from start to goal, returns false if no path to the goal has been found yet
+template<class State, class StateMath, class Map>
+bool RRT<State, StateMath, Map>::getGoalPath(std::vector<State>* path) {
+    path->clear();
+    if (goal.parent == nullptr) return false;
+    for (Node<State>* node = &goal; node != nullptr; node = node->parent) {
+        path->insert(path->begin(), node->state);
+    }
+    return true;
+}
+
 template<class State, class StateMath, class Map>
 void RRT<State, StateMath, Map>::clearDebugBuffer() {
     debugText = "";
@@ -10,6 +10,20 @@ void RRT<State, StateMath, Map>::configureRewiring(bool _enabled, float _neighbo
     rewiring_passes = _passes;
 }
 
+// incremental rewiring does RRT* choose-parent and rewire steps around every new sample, over its k = k_scale * log(n)
+// nearest neighbors.  this keeps the tree close to optimal as it grows, so the batch passes of rewireAll() become optional.
+template<class State, class StateMath, class Map>
+void RRT<State, StateMath, Map>::configureIncrementalRewiring(bool _enabled, float _k_scale) {
+    incremental_rewiring_enabled = _enabled;
+    incremental_rewiring_k_scale = _k_scale;
+}
+
+// propagation replaces the rewiring passes with a single rewirePropagate() call
+template<class State, class StateMath, class Map>
+void RRT<State, StateMath, Map>::configureRewiringPropagation(bool _enabled) {
+    rewiring_propagation_enabled = _enabled;
+}
+
 template<class State, class StateMath, class Map>
 void RRT<State, StateMath, Map>::rewireAll() {
     for (Node<State>* node = graph.first(); node != nullptr; node = node->next) {
@@ -28,10 +42,16 @@ void RRT<State, StateMath, Map>::rewireNode(Node<State> *target) {
         if (node != target) {
             if (approx_distance < neighborhood_distance_threshold) {
                 float edge_cost = state_math->edgeCost(&node->state, &target->state);
+                edge_cost_evaluations++;
                 float new_cost = node->cost + edge_cost;
                 if (new_cost < target->cost) {
+                    edge_obstacle_evaluations++;
                     if (!state_math->edgeInObstacle(&node->state, &target->state)) {
-                        target->parent = node;
+                        if (target == &goal) {
+                            goal.parent = node;
+                        } else {
+                            graph.setParent(target, node);
+                        }
                         float cost_delta = new_cost - target->cost;
                         apply_cost_delta_recursive(target, cost_delta);
                     }
@@ -41,15 +61,78 @@ void RRT<State, StateMath, Map>::rewireNode(Node<State> *target) {
     }
 }
 
+// dijkstra-style rewiring.  nodes are expanded cheapest first, offering themselves as the parent of each node in their
+// neighborhood.  whenever a node gets cheaper, it and its subtree go back on the queue, so an improvement reaches
+// everything downstream of it within the same call.  stops at the same fixed point as repeated rewireAll() passes:
+// no node can be reached more cheaply through any of its neighbors.
 template<class State, class StateMath, class Map>
-void RRT<State, StateMath, Map>::apply_cost_delta_recursive(Node<State> *root, float cost_delta) {
-    root->cost += cost_delta;
+void RRT<State, StateMath, Map>::rewirePropagate() {
     for (Node<State>* node = graph.first(); node != nullptr; node = node->next) {
-        if (node->parent == root && node != root) {
-            apply_cost_delta_recursive(node, cost_delta);
+        rewire_queue.push(std::make_pair(node->cost, node));
+    }
+    while (!rewire_queue.empty()) {
+        std::pair<float, Node<State>*> entry = rewire_queue.top();
+        rewire_queue.pop();
+        // costs only go down, so an entry that doesn't match the node's cost is stale
+        if (entry.first != entry.second->cost) continue;
+        rewire_propagate_from(entry.second);
+    }
+}
+
+template<class State, class StateMath, class Map>
+void RRT<State, StateMath, Map>::rewire_propagate_from(Node<State> *source) {
+    for (Node<State>* node = graph.first(); node != nullptr; node = node->next) {
+        if (node == source || node->parent == nullptr || node->cost <= source->cost) continue;
+        if (state_math->approx_distance(&source->state, &node->state) >= neighborhood_distance_threshold) continue;
+        float new_cost = source->cost + state_math->edgeCost(&source->state, &node->state);
+        edge_cost_evaluations++;
+        if (new_cost < node->cost) {
+            edge_obstacle_evaluations++;
+            if (!state_math->edgeInObstacle(&source->state, &node->state)) {
+                graph.setParent(node, source);
+                apply_cost_delta_recursive(node, new_cost - node->cost);
+                rewire_push_subtree(node);
+            }
         }
     }
-    if (goal.parent == root && &goal != root) {
+
+    if (goal.parent != nullptr && goal.cost > source->cost) {
+        if (state_math->approx_distance(&source->state, &goal.state) < neighborhood_distance_threshold) {
+            float new_cost = source->cost + state_math->edgeCost(&source->state, &goal.state);
+            edge_cost_evaluations++;
+            if (new_cost < goal.cost) {
+                edge_obstacle_evaluations++;
+                if (!state_math->edgeInObstacle(&source->state, &goal.state)) {
+                    goal.parent = source;
+                    goal.cost = new_cost;
+                }
+            }
+        }
+    }
+}
+
+template<class State, class StateMath, class Map>
+void RRT<State, StateMath, Map>::rewire_push_subtree(Node<State> *root) {
+    rewire_queue.push(std::make_pair(root->cost, root));
+    for (Node<State>* node = root->first_child; node != nullptr; node = node->next_sibling) {
+        rewire_push_subtree(node);
+    }
+}
+
+template<class State, class StateMath, class Map>
+void RRT<State, StateMath, Map>::getRewireStats(long *_edge_cost_evaluations, long *_edge_obstacle_evaluations) {
+    *_edge_cost_evaluations = edge_cost_evaluations;
+    *_edge_obstacle_evaluations = edge_obstacle_evaluations;
+}
+
+template<class State, class StateMath, class Map>
+void RRT<State, StateMath, Map>::apply_cost_delta_recursive(Node<State> *root, float cost_delta) {
+    root->cost += cost_delta;
+    if (root == &goal) return;
+    for (Node<State>* node = root->first_child; node != nullptr; node = node->next_sibling) {
+        apply_cost_delta_recursive(node, cost_delta);
+    }
+    if (goal.parent == root) {
         apply_cost_delta_recursive(&goal, cost_delta);
     }
 }
@@ -5,10 +5,12 @@
 
 #include <cfloat>
 
+// _max_attempts limits how many random states addRandomSample() tries before giving up, 0 means keep trying forever
 template<class State, class StateMath, class Map>
-void RRT<State, StateMath, Map>::configureSampling(int _passes, bool _allow_costly_nodes) {
+void RRT<State, StateMath, Map>::configureSampling(int _passes, bool _allow_costly_nodes, int _max_attempts) {
     sampling_passes = _passes;
     allow_costly_nodes = _allow_costly_nodes;
+    sampling_max_attempts = _max_attempts;
 }
 
 template<class State, class StateMath, class Map>
@@ -18,44 +20,66 @@ void RRT<State, StateMath, Map>::initRandomSamples() {
 }
 
 template <class State, class StateMath, class Map>
-void RRT<State,StateMath,Map>::addRandomSample() {
+bool RRT<State,StateMath,Map>::addRandomSample() {
     State candidate, candidate_from_edge_calc;
     Node<State>* nearest = nullptr;
     Node<State>* newnode = nullptr;
+    std::vector<Node<State>*> neighbors;
 
     bool suitable_found = false;
-    while (!suitable_found) {
+    for (int attempt = 0; !suitable_found && (sampling_max_attempts == 0 || attempt < sampling_max_attempts); attempt++) {
         candidate = state_math->getRandomState();
-        nearest = getNearestNode(&candidate);
+        float cost_limit = goal.cost < cost_bound ? goal.cost : cost_bound;
+        // even a straight shot from the start through the candidate can't beat the best path, so don't bother
+        if (!allow_costly_nodes && state_math->costToGo(&start->state, &candidate) + state_math->costToGo(&candidate, &goal.state) >= cost_limit) {
+            continue;
+        }
+        if (incremental_rewiring_enabled) {
+            int k = (int)ceilf(incremental_rewiring_k_scale * logf(graph.size() + 1));
+            getNearestNodes(&candidate, k, &neighbors);
+            nearest = neighbors.empty() ? nullptr : neighbors[0];
+        } else {
+            nearest = getNearestNode(&candidate);
+        }
         if (nearest != nullptr) {
-            if (!state_math->edgeInObstacle(&nearest->state, &candidate)) {
-                // edgeCost can modify candidate if it has parameters that are meant to be set after finding a solution.
+            EdgeEvaluation<State> edge = state_math->evaluateEdge(&nearest->state, &candidate);
+            if (!edge.collides) {
+                // the edge calculation can modify candidate if it has parameters that are meant to be set after finding a solution.
                 // this is essentially part of the sampling process, but instead of sampling all random values, we sample
                 // some random values and then generate the rest based on a working solution.
                 // todo: does this indicate a problem?
-                float edgecost = state_math->edgeCost(&nearest->state, &candidate, &candidate_from_edge_calc);
-                float cost = nearest->cost + edgecost;
-                if ((cost < goal.cost || allow_costly_nodes) && cost < INFINITY) {
+                candidate_from_edge_calc = edge.dest;
+                float cost = nearest->cost + edge.cost;
+                Node<State>* parent = nearest;
+                if (incremental_rewiring_enabled) {
+                    choose_parent(&candidate, &neighbors, &parent, &cost, &candidate_from_edge_calc);
+                }
+                float estimate = cost + state_math->costToGo(&candidate_from_edge_calc, &goal.state);
+                if ((estimate < cost_limit || allow_costly_nodes) && cost < INFINITY) {
                     suitable_found = true;
-                    newnode = graph.addNode(&candidate_from_edge_calc, nearest, cost);
+                    newnode = graph.addNode(&candidate_from_edge_calc, parent, cost);
+                    prune_queue.push(std::make_pair(estimate, newnode));
                     addDebugText("New Node Orig: " + candidate.toString());
                     addDebugText("New Node Calc: " + candidate_from_edge_calc.toString());
-                    addDebugText("Neighbor: " + nearest->state.toString());
-                    addDebugText("Edge Cost: " + to_string(edgecost));
+                    addDebugText("Neighbor: " + parent->state.toString());
+                    addDebugText("Edge Cost: " + to_string(cost - parent->cost));
                     addDebugText("Graph now has " + to_string(graph.size()) + " nodes");
                     addDebugText("");
 
-
+                    if (incremental_rewiring_enabled) {
+                        rewire_neighbors(newnode, &neighbors);
+                    }
 
                     float goal_distance = state_math->distance(&newnode->state, &goal.state);
                     if (goal_distance < goal_distance_threshold) {
-                        if (!state_math->edgeInObstacle(&newnode->state, &goal.state)) {
-                            float goal_cost = newnode->cost + state_math->edgeCost(&newnode->state, &goal.state);
+                        EdgeEvaluation<State> goal_edge = state_math->evaluateEdge(&newnode->state, &goal.state);
+                        if (!goal_edge.collides) {
+                            float goal_cost = newnode->cost + goal_edge.cost;
                             if (goal_cost < goal.cost) {
                                 goal.cost = goal_cost;
                                 goal.parent = newnode;
                                 if (!allow_costly_nodes) {
-                                    delete_high_cost_nodes(goal.cost);
+                                    prune_nodes(goal.cost);
                                 }
                             }
                         }
@@ -64,6 +88,41 @@ void RRT<State,StateMath,Map>::addRandomSample() {
             }
         }
     }
+    return suitable_found;
+}
+
+// RRT* choose-parent: connect the candidate through whichever neighbor gives it the lowest cost-to-come.
+// parent, cost and candidate_from_edge_calc start out describing the connection to the nearest node.
+template <class State, class StateMath, class Map>
+void RRT<State,StateMath,Map>::choose_parent(State* candidate, std::vector<Node<State>*>* neighbors, Node<State>** parent, float* cost, State* candidate_from_edge_calc) {
+    State updated;
+    for (Node<State>* neighbor : *neighbors) {
+        if (neighbor == *parent) continue;
+        float new_cost = neighbor->cost + state_math->edgeCost(&neighbor->state, candidate, &updated);
+        if (new_cost < *cost) {
+            if (!state_math->edgeInObstacle(&neighbor->state, candidate)) {
+                *parent = neighbor;
+                *cost = new_cost;
+                *candidate_from_edge_calc = updated;
+            }
+        }
+    }
+}
+
+// RRT* rewire: neighbors that are cheaper to reach through the new node get it as their parent.
+// the new node is a leaf, so this can't create a cycle.
+template <class State, class StateMath, class Map>
+void RRT<State,StateMath,Map>::rewire_neighbors(Node<State>* newnode, std::vector<Node<State>*>* neighbors) {
+    for (Node<State>* neighbor : *neighbors) {
+        if (neighbor == newnode->parent || neighbor->parent == nullptr) continue;
+        float new_cost = newnode->cost + state_math->edgeCost(&newnode->state, &neighbor->state);
+        if (new_cost < neighbor->cost) {
+            if (!state_math->edgeInObstacle(&newnode->state, &neighbor->state)) {
+                graph.setParent(neighbor, newnode);
+                apply_cost_delta_recursive(neighbor, new_cost - neighbor->cost);
+            }
+        }
+    }
 }
 
 template <class State, class StateMath, class Map>
@@ -80,13 +139,59 @@ Node<State>* RRT<State,StateMath,Map>::getNearestNode(State* state) {
     return best_node;
 }
 
-template<class State, class StateMath, class Map>
-void RRT<State, StateMath, Map>::delete_high_cost_nodes(float cost_threshold) {
+// the count nodes closest to state, nearest first
+template <class State, class StateMath, class Map>
+void RRT<State,StateMath,Map>::getNearestNodes(State* state, int count, std::vector<Node<State>*>* nearest) {
+    std::vector<float> distances;
+    nearest->clear();
     for (Node<State>* node = graph.first(); node != nullptr; node = node->next) {
-        if (node->cost > cost_threshold) {
+        float distance = state_math->distance(&node->state, state);
+        if ((int)nearest->size() == count && distance >= distances.back()) continue;
+        int i = nearest->size();
+        if (i == count) {
+            nearest->pop_back();
+            distances.pop_back();
+            i--;
+        }
+        while (i > 0 && distances[i-1] > distance) i--;
+        nearest->insert(nearest->begin() + i, node);
+        distances.insert(distances.begin() + i, distance);
+    }
+}
+
+// branch and bound: delete nodes whose cost + costToGo exceeds the threshold, along with their subtrees.
+// only the queue entries above the threshold are visited.  costs only drop after a node is queued (rewiring), so an
+// entry whose node has since become cheaper is requeued with its current estimate instead of deleted.
+// costToGo is consistent, so a subtree never estimates lower than its root, and the goal's ancestors never exceed goal.cost.
+// a threshold below goal.cost (a bound from another planner) can delete the goal's ancestors, and then this tree no
+// longer has a path to the goal.
+template<class State, class StateMath, class Map>
+void RRT<State, StateMath, Map>::prune_nodes(float cost_threshold) {
+    while (!prune_queue.empty() && prune_queue.top().first > cost_threshold) {
+        Node<State>* node = prune_queue.top().second;
+        prune_queue.pop();
+        if (node->deleted) continue;
+        float estimate = node->cost + state_math->costToGo(&node->state, &goal.state);
+        if (estimate > cost_threshold) {
             graph.delNode(node);
+        } else {
+            prune_queue.push(std::make_pair(estimate, node));
         }
     }
+    if (goal.parent != nullptr && goal.parent->deleted) {
+        goal.parent = nullptr;
+        goal.cost = INFINITY;
+    }
+}
+
+// accept a goal cost found elsewhere as an upper bound on useful node costs, and prune against it
+template<class State, class StateMath, class Map>
+void RRT<State, StateMath, Map>::setCostBound(float cost) {
+    if (cost >= cost_bound) return;
+    cost_bound = cost;
+    if (!allow_costly_nodes) {
+        prune_nodes(cost_bound);
+    }
 }
 
 template <class State, class StateMath, class Map>
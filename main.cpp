@@ -1,4 +1,6 @@
 #include "RRT.h"
+#include "RRTPortfolio.h"
+#include "RRTPartitioned2D.h"
 
 #include "statespace/2d/State2D.h"
 #include "statespace/2d/State2DMath.h"
@@ -21,6 +23,8 @@
 #include <iostream>
 #include <cstring>
 #include <chrono>
+#include <thread>
+#include <vector>
 
 using namespace std;
 using namespace std::chrono;
@@ -34,12 +38,48 @@ void main_2d_walls() {
     rrt.setStartState(&start);
     rrt.setGoalState(&goal, 0.01);
     rrt.configureSampling(5001, false);
-    rrt.configureRewiring(true, 0.05, 10);
+    rrt.configureRewiring(false, 0.05, 10);
+    rrt.configureIncrementalRewiring(true, REWIRE_K_SCALE_DEFAULT);
     rrt.configureDebugOutput(true, true, "output/2d/walls/", 0, 0);
     rrt.run();
     cout << "2d Walls: Final path cost: " << rrt.getGoalCost() << endl;
 }
 
+void main_2d_walls_portfolio() {
+    Map2D map("maps/2d/walls.png");
+    int instance_count = max(1, (int)std::thread::hardware_concurrency());
+    std::vector<State2DMath> state_math(instance_count, State2DMath(1));
+    std::vector<State2DMath*> state_math_ptrs;
+    for (State2DMath& instance_state_math : state_math) state_math_ptrs.push_back(&instance_state_math);
+    RRTPortfolio<State2D,State2DMath,Map2D> rrt(&map, state_math_ptrs);
+    State2D start{10*5, 215*5};
+    State2D goal(275*5, 15*5);
+    rrt.setStartState(&start);
+    rrt.setGoalState(&goal, 0.01);
+    rrt.configureSampling(20001, false);
+    rrt.configureRewiring(true, 0.05, 10);
+    // main_2d_walls gets to about 2556 on its own, stop once any instance is close to that
+    rrt.configurePortfolio(2600, PORTFOLIO_BROADCAST_INTERVAL_DEFAULT);
+    rrt.configureDebugOutput("output/2d/walls_portfolio/");
+    rrt.run();
+    cout << "2d Walls Portfolio: " << instance_count << " instances, best instance " << rrt.getBestInstance() << ", final path cost: " << rrt.getGoalCost() << endl;
+}
+
+void main_2d_walls_partitioned() {
+    Map2D map("maps/2d/walls.png");
+    State2DMath state_math(1);
+    RRTPartitioned2D<State2DMath> rrt(&map, &state_math);
+    State2D start{10*5, 215*5};
+    State2D goal(275*5, 15*5);
+    rrt.setStartState(&start);
+    rrt.setGoalState(&goal, 0.01);
+    rrt.configurePartition(3, 3, 6, max(1, (int)std::thread::hardware_concurrency()));
+    rrt.configureSampling(501, false);
+    rrt.configureDebugOutput("output/2d/walls_partitioned/");
+    rrt.run();
+    cout << "2d Walls Partitioned: Final path cost: " << rrt.getGoalCost() << endl;
+}
+
 void main_2d_field() {
     Map2D map("maps/2d/field.png");
     State2DMath state_math(10);
@@ -49,7 +89,8 @@ void main_2d_field() {
     rrt.setStartState(&start);
     rrt.setGoalState(&goal, 0.01);
     rrt.configureSampling(5001, false);
-    rrt.configureRewiring(true, 0.05, 10);
+    rrt.configureRewiring(false, 0.05, 10);
+    rrt.configureIncrementalRewiring(true, REWIRE_K_SCALE_DEFAULT);
     rrt.configureDebugOutput(true, true, "output/2d/field/", 0, 0);
     rrt.run();
     cout << "2D Field: Final path cost: " << rrt.getGoalCost() << endl;
@@ -64,7 +105,8 @@ void main_2d_elevation() {
     rrt.setStartState(&start);
     rrt.setGoalState(&goal, 0.01);
     rrt.configureSampling(10001, false);
-    rrt.configureRewiring(true, 0.05, 10);
+    rrt.configureRewiring(false, 0.05, 10);
+    rrt.configureIncrementalRewiring(true, REWIRE_K_SCALE_DEFAULT);
     rrt.configureDebugOutput(true, true, "output/2d/elevation/", 0, 0);
     rrt.run();
     cout << "2D Elevation: Final path cost: " << rrt.getGoalCost() << endl;
@@ -79,12 +121,29 @@ void main_3d() {
     rrt.setStartState(&start_3d);
     rrt.setGoalState(&goal_3d, 0.05);
     rrt.configureSampling(20001, true);
-    rrt.configureRewiring(true, 0.25, 10);
+    rrt.configureRewiring(false, 0.25, 10);
+    rrt.configureIncrementalRewiring(true, REWIRE_K_SCALE_DEFAULT);
     rrt.configureDebugOutput(true, true, "output/3d/", 1920, 1080);
     rrt.run();
     cout << "3D: Final path cost: " << rrt.getGoalCost() << endl;
 }
 
+void main_3d_voxels() {
+    Map3D map_3d("maps/3d/voxels1.txt");
+    State3DMath state_math_3d(1);
+    RRT<State3D,State3DMath,Map3D> rrt(&map_3d, &state_math_3d);
+    State3D start_3d{5, 5, 5};
+    State3D goal_3d(95, 95, 95);
+    rrt.setStartState(&start_3d);
+    rrt.setGoalState(&goal_3d, 0.05);
+    rrt.configureSampling(20001, true);
+    rrt.configureRewiring(false, 0.25, 10);
+    rrt.configureIncrementalRewiring(true, REWIRE_K_SCALE_DEFAULT);
+    rrt.configureDebugOutput(true, true, "output/3d/voxels/", 1920, 1080);
+    rrt.run();
+    cout << "3D Voxels: Final path cost: " << rrt.getGoalCost() << endl;
+}
+
 void main_floater() {
     MapFloater map("maps/floater/floater.png", 300);
     StateFloaterMath state_math(20, 1);
@@ -107,10 +166,11 @@ void main_racer() {
     ModelRacer model(150, 30, 2, 0.1, 0.0012, 0.001);
     StateRacerMath state_math;
     state_math.setMax(60, 2, 100, 100);
-    state_math.setRes(20, 1000, 1000);
+    state_math.setRes(20, 500, 500);
     state_math.setSteps(20, 20, 40, 100);
     state_math.setModel(&model);
     state_math.setVis("output/racer/math/");
+    state_math.setLUTCache("output/racer/cache/");
     RRT<StateRacer,StateRacerMath,MapRacer> rrt(&map, &state_math);
     StateRacer start{350, 35, 0, -M_PI_2};
     StateRacer goal(390, 35, 0, -M_PI_2);
@@ -129,6 +189,12 @@ int main(int argc, char* argv[]) {
     if (argc == 1 || strcmp(argv[1], "2d_walls") == 0) {
         main_2d_walls();
     }
+    if (argc == 1 || strcmp(argv[1], "2d_walls_portfolio") == 0) {
+        main_2d_walls_portfolio();
+    }
+    if (argc == 1 || strcmp(argv[1], "2d_walls_partitioned") == 0) {
+        main_2d_walls_partitioned();
+    }
     if (argc == 1 || strcmp(argv[1], "2d_field") == 0) {
         main_2d_field();
     }
@@ -138,6 +204,9 @@ int main(int argc, char* argv[]) {
     if (argc == 1 || strcmp(argv[1], "3d") == 0) {
         main_3d();
     }
+    if (argc == 1 || strcmp(argv[1], "3d_voxels") == 0) {
+        main_3d_voxels();
+    }
     if (argc == 1 || strcmp(argv[1], "floater") == 0) {
         main_floater();
     }
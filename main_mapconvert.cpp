@@ -0,0 +1,87 @@
+#include "statespace/2d/Map2D.h"
+#include "statespace/3d/Map3D.h"
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+static bool ends_with(string text, string suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+template <class Map>
+static int convert(string input, string output, void (Map::*save)(string), void (*prepare)(Map*)=nullptr) {
+    auto start = steady_clock::now();
+    Map map(input);
+    if (prepare != nullptr) prepare(&map);
+    auto loaded = steady_clock::now();
+    (map.*save)(output);
+    auto saved = steady_clock::now();
+
+    cout << "Loaded and preprocessed " << input << " in " << duration_cast<milliseconds>(loaded - start).count() << " ms" << endl;
+    cout << "Wrote " << output << " in " << duration_cast<milliseconds>(saved - loaded).count() << " ms" << endl;
+    cout << "Content hash: " << hex << map.getContentHash() << dec << endl;
+
+    auto reload_start = steady_clock::now();
+    Map reloaded(output);
+    auto reload_end = steady_clock::now();
+    if (reloaded.getContentHash() != map.getContentHash() || !reloaded.verifyContentHash()) {
+        cout << "Reloading " << output << " gave a different content hash" << endl;
+        return 1;
+    }
+    cout << "Reloaded " << output << " in " << duration_cast<microseconds>(reload_end - reload_start).count() << " us" << endl;
+    return 0;
+}
+
+// the cost layers of a .map2d file depend on the planner's cost_scale, so they're made for the scales on the command
+// line, and the run lookup sums too with --runs
+static vector<float> cost_scales;
+static bool runs = false;
+
+static void prepare_map2d(Map2D* map) {
+    for (float cost_scale : cost_scales) {
+        map->getCostField(cost_scale);
+        if (runs) {
+            double* row_sums;
+            double* column_sums;
+            map->getCostSums(cost_scale, &row_sums, &column_sums);
+        }
+    }
+    if (runs) {
+        map->getObstacleRowCounts();
+        map->getObstacleColumnCounts();
+    }
+}
+
+// Preprocesses a map once into a binary format that is memory mapped on later runs, instead of being parsed and having
+// its acceleration structures rebuilt.  png maps become .map2d files, with their occupancy, clearance and occupancy
+// level layers, and cost layers for any cost scales given.  3d text maps (boxes or voxels) become .map3d files, with
+// their BVH and voxel bricks.
+int main(int argc, char* argv[]) {
+    bool map3d = argc == 3 && ends_with(argv[2], MAP3D_FILE_EXTENSION);
+    bool map2d = argc >= 3 && ends_with(argv[2], MAP2D_FILE_EXTENSION);
+    for (int i = 3; map2d && i < argc; i++) {
+        if (strcmp(argv[i], "--runs") == 0) {
+            runs = true;
+            continue;
+        }
+        char* end;
+        cost_scales.push_back(strtof(argv[i], &end));
+        map2d = end != argv[i] && *end == 0;
+    }
+    if (!map2d && !map3d) {
+        cout << "usage: " << argv[0] << " <input.png> <output" << MAP2D_FILE_EXTENSION << "> [--runs] [cost_scale ...]" << endl;
+        cout << "       " << argv[0] << " <input.txt> <output" << MAP3D_FILE_EXTENSION << ">" << endl;
+        return 1;
+    }
+
+    if (map3d) {
+        return convert<Map3D>(argv[1], argv[2], &Map3D::saveMap3D);
+    }
+    return convert<Map2D>(argv[1], argv[2], &Map2D::saveMap2D, prepare_map2d);
+}
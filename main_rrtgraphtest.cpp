@@ -1,5 +1,8 @@
 #include "RRTGraph.h"
+#include "RRT.h"
 #include "statespace/2d/State2D.h"
+#include "statespace/2d/State2DMath.h"
+#include "statespace/2d/Map2D.h"
 
 #include <iostream>
 
@@ -56,16 +59,16 @@ int main(int argc, char* argv[]) {
     node5 = graph.addNode(&state);
     cout << graph.toString() << endl;
 
-    cout << "node2->parent = node1" << endl;
-    node2->parent = node1;
+    cout << "graph.setParent(node2, node1)" << endl;
+    graph.setParent(node2, node1);
     cout << graph.toString() << endl;
 
-    cout << "node3->parent = node1" << endl;
-    node3->parent = node1;
+    cout << "graph.setParent(node3, node1)" << endl;
+    graph.setParent(node3, node1);
     cout << graph.toString() << endl;
 
-    cout << "node4->parent = node3" << endl;
-    node4->parent = node3;
+    cout << "graph.setParent(node4, node3)" << endl;
+    graph.setParent(node4, node3);
     cout << graph.toString() << endl;
 
     cout << "graph.delNode(4)" << endl;
@@ -80,4 +83,44 @@ int main(int argc, char* argv[]) {
     cout << "node1->cost" << endl;
     cout << node1->cost << endl;
 
+    // a cost bound from another planner below the tree's own goal cost prunes the goal's ancestors, so the tree has to
+    // drop its path to the goal rather than keep one through deleted nodes
+    Map2D map("maps/2d/walls.png");
+    State2DMath state_math(1);
+    RRT<State2D,State2DMath,Map2D> rrt(&map, &state_math);
+    State2D start{10*5, 215*5};
+    State2D goal(275*5, 15*5);
+    rrt.setStartState(&start);
+    rrt.setGoalState(&goal, 0.01);
+    rrt.configureSampling(5001, false);
+    rrt.initRandomSamples();
+    for (int i = 0; i < 5001 && rrt.getGoalCost() == INFINITY; i++) {
+        rrt.addRandomSample();
+    }
+    float goal_cost = rrt.getGoalCost();
+    cout << "rrt.getGoalCost()" << endl;
+    cout << goal_cost << endl;
+
+    cout << "rrt.setCostBound(" << goal_cost / 2 << ")" << endl;
+    rrt.setCostBound(goal_cost / 2);
+    vector<State2D> path;
+    bool found = rrt.getGoalPath(&path);
+    cout << "rrt.getGoalCost() " << rrt.getGoalCost() << ", rrt.getGoalPath() " << found << endl;
+    if (goal_cost == INFINITY || rrt.getGoalCost() != INFINITY || found) {
+        cout << "FAILED: the goal kept a path through pruned nodes" << endl;
+        return 1;
+    }
+    rrt.renderVis();
+
+    for (int i = 0; i < 5001 && rrt.getGoalCost() == INFINITY; i++) {
+        rrt.addRandomSample();
+    }
+    found = rrt.getGoalPath(&path);
+    cout << "rrt.getGoalCost() " << rrt.getGoalCost() << ", rrt.getGoalPath() " << found << endl;
+    if (found && !(path.front() == start)) {
+        cout << "FAILED: the goal path doesn't start at the start state" << endl;
+        return 1;
+    }
+
+    return 0;
 }
\ No newline at end of file
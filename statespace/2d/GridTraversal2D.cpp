@@ -0,0 +1,38 @@
+#include "GridTraversal2D.h"
+#include <cmath>
+
+GridTraversal2D::GridTraversal2D(double _x0, double _y0, double _x1, double _y1) {
+    x0 = _x0;
+    y0 = _y0;
+    dx = _x1 - _x0;
+    dy = _y1 - _y0;
+    length = sqrt(dx * dx + dy * dy);
+    step_x = dx > 0 ? 1 : (dx < 0 ? -1 : 0);
+    step_y = dy > 0 ? 1 : (dy < 0 ? -1 : 0);
+    t_delta_x = dx != 0 ? 1.0 / fabs(dx) : INFINITY;
+    t_delta_y = dy != 0 ? 1.0 / fabs(dy) : INFINITY;
+    start_at(0);
+}
+
+// the next pixel is the one containing the point at t.  pixel boundaries are measured from the segment's origin,
+// so restarting part way along doesn't accumulate any error.
+void GridTraversal2D::start_at(double t) {
+    x = (int)floor(x0 + dx * t);
+    y = (int)floor(y0 + dy * t);
+    t_max_x = step_x > 0 ? (x + 1 - x0) / dx : (step_x < 0 ? (x - x0) / dx : INFINITY);
+    t_max_y = step_y > 0 ? (y + 1 - y0) / dy : (step_y < 0 ? (y - y0) / dy : INFINITY);
+    t_enter = t;
+    started = false;
+}
+
+// jump ahead so the next pixel is the one distance further along the segment than where the current pixel was entered.
+// pixels in between are never visited.
+void GridTraversal2D::skip(float distance) {
+    double t = t_enter + distance / length;
+    if (!(t > t_exit)) return;
+    if (t >= 1) {
+        finished = true;
+        return;
+    }
+    start_at(t);
+}
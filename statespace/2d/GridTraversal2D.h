@@ -0,0 +1,60 @@
+#ifndef GRIDTRAVERSAL2D_H
+#define GRIDTRAVERSAL2D_H
+
+// Walks the pixels crossed by a line segment, in order, visiting each one exactly once. (Amanatides & Woo)
+// Pixel (x, y) covers [x, x+1) x [y, y+1).  A segment ending exactly on a pixel edge doesn't visit the pixel beyond it.
+//
+//   GridTraversal2D cells(a.x, a.y, b.x, b.y);
+//   while (cells.next()) { ... cells.getX(), cells.getY(), cells.getLength() ... }
+
+class GridTraversal2D {
+
+public:
+    GridTraversal2D(double _x0, double _y0, double _x1, double _y1);
+    void skip(float distance);
+
+    // moves to the next pixel, returns false once the segment is used up
+    inline bool next() {
+        if (finished) return false;
+        if (started) {
+            // which way to step is close to random on diagonal lines, so this is written to compile without branches
+            bool step_in_x = t_max_x < t_max_y;
+            x += step_in_x ? step_x : 0;
+            y += step_in_x ? 0 : step_y;
+            t_enter = step_in_x ? t_max_x : t_max_y;
+            t_max_x += step_in_x ? t_delta_x : 0;
+            t_max_y += step_in_x ? 0 : t_delta_y;
+            if (t_enter >= 1) {
+                finished = true;
+                return false;
+            }
+        }
+        started = true;
+        t_exit = t_max_x < t_max_y ? t_max_x : t_max_y;
+        if (t_exit > 1) t_exit = 1;
+        return true;
+    }
+
+    inline int getX() { return x; }
+    inline int getY() { return y; }
+
+    // length of the segment inside the current pixel
+    inline float getLength() { return (t_exit - t_enter) * length; }
+
+private:
+    void start_at(double t);
+
+    double x0, y0, dx, dy;
+    float length = 0;
+
+    int x = 0, y = 0;
+    int step_x = 0, step_y = 0;
+    // t runs from 0 at the start of the segment to 1 at the end
+    double t_delta_x = 0, t_delta_y = 0;
+    double t_max_x = 0, t_max_y = 0;
+    double t_enter = 0, t_exit = 0;
+    bool started = false;
+    bool finished = false;
+};
+
+#endif
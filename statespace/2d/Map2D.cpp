@@ -1,11 +1,50 @@
 #include <cmath>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "Map2D.h"
+#include "GridTraversal2D.h"
+#include "utils.h"
 
-Map2D::Map2D(std::string pngfile) {
-    load_png(pngfile);
+// the layers follow the header in this order, each starting on a FILE_ALIGNMENT boundary:
+// grayscale and clearance as floats, then the tiles of each occupancy level from level 0 up, then the cost_scale of
+// each cost field followed by the cost_scale of each pair of cost sums, the cost fields, the row and column sums of
+// each pair, and the obstacle row and column counts if has_obstacle_counts.
+// content_hash is fnv1a_64 of the grayscale layer, which every other layer is made from.
+struct Map2DFileHeader {
+    char magic[8];
+    uint32_t version;
+    int32_t width;
+    int32_t height;
+    int32_t occupancy_level_count;
+    int32_t cost_field_count;
+    int32_t cost_sum_count;
+    int32_t has_obstacle_counts;
+    uint64_t content_hash;
+};
+
+static const char MAP2D_FILE_MAGIC[8] = {'R', 'R', 'T', 'M', 'A', 'P', '2', 'D'};
+static const size_t FILE_ALIGNMENT = 64;
+
+static size_t align_offset(size_t offset) {
+    return (offset + FILE_ALIGNMENT - 1) / FILE_ALIGNMENT * FILE_ALIGNMENT;
+}
+
+Map2D::Map2D(std::string filename) {
+    if (filename.size() >= MAP2D_FILE_EXTENSION.size() &&
+        filename.compare(filename.size() - MAP2D_FILE_EXTENSION.size(), MAP2D_FILE_EXTENSION.size(), MAP2D_FILE_EXTENSION) == 0) {
+        load_map2d(filename);
+        return;
+    }
+    load_png(filename);
     make_grayscale();
-    resetVis();
+    make_occupancy();
+    make_clearance();
+    make_occupancy_levels();
 }
 
 void Map2D::load_png(std::string pngfile) {
@@ -58,14 +97,12 @@ void Map2D::load_png(std::string pngfile) {
 
     if (image_rows) abort();
 
+    // one block for the whole image, with image_rows pointing into it.  it's freed once grayscale is made.
+    size_t rowbytes = png_get_rowbytes(png,info);
+    png_bytep pixels = (png_bytep)malloc(rowbytes * image_height);
     image_rows = (png_bytep*)malloc(sizeof(png_bytep) * image_height);
     for(int y = 0; y < image_height; y++) {
-        image_rows[y] = (png_byte*)malloc(png_get_rowbytes(png,info));
-    }
-
-    vis_rows = (png_bytep*)malloc(sizeof(png_bytep) * image_height);
-    for(int y = 0; y < image_height; y++) {
-        vis_rows[y] = (png_byte*)malloc(png_get_rowbytes(png,info));
+        image_rows[y] = pixels + rowbytes * y;
     }
 
     png_read_image(png, image_rows);
@@ -76,21 +113,429 @@ void Map2D::load_png(std::string pngfile) {
 }
 
 void Map2D::make_grayscale() {
-    grayscale = (float*)malloc(image_width * image_height * sizeof(float));
+    grayscale = (float*)malloc((size_t)image_width * image_height * sizeof(float));
+    parallel_for(image_height, 1, [this](int begin, int end) {
+        for (int height_pos = begin; height_pos < end; height_pos++) {
+            png_bytep row = image_rows[height_pos];
+            float* gray_row = &grayscale[grayoffset(0, height_pos)];
+            for (int width_pos = 0; width_pos < image_width; width_pos++) {
+                png_bytep px = &(row[width_pos * 4]);
+                gray_row[width_pos] = ((int)px[0] + (int)px[1] + (int)px[2]) / 765.0f;
+            }
+        }
+    });
+    free(image_rows[0]);
+    free(image_rows);
+    image_rows = NULL;
+}
+
+void Map2D::make_occupancy() {
+    occupancy = new OccupancyBitmap(image_width, image_height);
+    parallel_for(image_height, 8, [this](int begin, int end) {
+        for (int height_pos = begin; height_pos < end; height_pos++) {
+            for (int width_pos = 0; width_pos < image_width; width_pos++) {
+                occupancy->set(width_pos, height_pos, grayscale[grayoffset(width_pos, height_pos)] < MAP2D_OBSTACLE_THRESHOLD);
+            }
+        }
+    });
+}
+
+// euclidean distance transform of the obstacle pixels, done as a pass down the columns and then along the rows
+// every column and then every row is independent, so each pass is split across threads with their own scratch space
+void Map2D::make_clearance() {
+    const float FAR = 1e20f;
+    int size = image_width > image_height ? image_width : image_height;
+
+    clearance = (float*)malloc((size_t)image_width * image_height * sizeof(float));
+    parallel_for(image_height, 1, [this, FAR](int begin, int end) {
+        for (int height_pos = begin; height_pos < end; height_pos++) {
+            for (int width_pos = 0; width_pos < image_width; width_pos++) {
+                clearance[grayoffset(width_pos, height_pos)] = occupancy->get(width_pos, height_pos) ? 0 : FAR;
+            }
+        }
+    });
+
+    parallel_for(image_width, 1, [this, size](int begin, int end) {
+        float* f = (float*)malloc(size * sizeof(float));
+        float* d = (float*)malloc(size * sizeof(float));
+        int* v = (int*)malloc(size * sizeof(int));
+        float* z = (float*)malloc((size + 1) * sizeof(float));
+        for (int width_pos = begin; width_pos < end; width_pos++) {
+            for (int height_pos = 0; height_pos < image_height; height_pos++) {
+                f[height_pos] = clearance[grayoffset(width_pos, height_pos)];
+            }
+            distance_transform_1d(f, image_height, d, v, z);
+            for (int height_pos = 0; height_pos < image_height; height_pos++) {
+                clearance[grayoffset(width_pos, height_pos)] = d[height_pos];
+            }
+        }
+        free(f);
+        free(d);
+        free(v);
+        free(z);
+    });
+
+    parallel_for(image_height, 1, [this, size, FAR](int begin, int end) {
+        float* d = (float*)malloc(size * sizeof(float));
+        int* v = (int*)malloc(size * sizeof(int));
+        float* z = (float*)malloc((size + 1) * sizeof(float));
+        for (int height_pos = begin; height_pos < end; height_pos++) {
+            float* row = &clearance[grayoffset(0, height_pos)];
+            distance_transform_1d(row, image_width, d, v, z);
+            for (int width_pos = 0; width_pos < image_width; width_pos++) {
+                row[width_pos] = d[width_pos] >= FAR ? INFINITY : sqrtf(d[width_pos]);
+            }
+        }
+        free(d);
+        free(v);
+        free(z);
+    });
+}
+
+// max pooling, 2x2 blocks at a time.  pixels past the edge of the map count as obstacles, like in occupancy itself.
+void Map2D::make_occupancy_levels() {
+    int size = image_width > image_height ? image_width : image_height;
+    occupancy_level_count = 1;
+    while ((1 << (occupancy_level_count - 1)) < size) occupancy_level_count++;
+
+    occupancy_levels = (OccupancyBitmap**)malloc(occupancy_level_count * sizeof(OccupancyBitmap*));
+    occupancy_levels[0] = occupancy;
+    for (int level = 1; level < occupancy_level_count; level++) {
+        int level_width = (image_width + (1 << level) - 1) >> level;
+        int level_height = (image_height + (1 << level) - 1) >> level;
+        OccupancyBitmap* below = occupancy_levels[level - 1];
+        OccupancyBitmap* above = new OccupancyBitmap(level_width, level_height);
+        occupancy_levels[level] = above;
+        parallel_for(level_height, 8, [below, above, level_width](int begin, int end) {
+            for (int height_pos = begin; height_pos < end; height_pos++) {
+                for (int width_pos = 0; width_pos < level_width; width_pos++) {
+                    bool occupied = below->get(width_pos * 2, height_pos * 2) || below->get(width_pos * 2 + 1, height_pos * 2) ||
+                                    below->get(width_pos * 2, height_pos * 2 + 1) || below->get(width_pos * 2 + 1, height_pos * 2 + 1);
+                    above->set(width_pos, height_pos, occupied);
+                }
+            }
+        });
+    }
+}
+
+bool Map2D::blocks_are_obstacle(int level, int min_x, int min_y, int max_x, int max_y) {
+    for (int height_pos = min_y; height_pos <= max_y; height_pos++) {
+        for (int width_pos = min_x; width_pos <= max_x; width_pos++) {
+            if (occupancy_levels[level]->get(width_pos, height_pos)) return true;
+        }
+    }
+    return false;
+}
+
+// the same answer as walking every pixel the segment crosses, but coarse to fine.
+// pieces of the segment are taken in bisection order, so the midpoint is looked at first, then the quarter points, and so on.
+// a piece whose bounding box sits in at most 2x2 free blocks of some level is clear without looking at its pixels,
+// and pieces down to 2x2 pixels that still touch an obstacle get walked exactly.
+bool Map2D::getSegmentIsObstacle(float x0, float y0, float x1, float y1) {
+    const int QUEUE_SIZE = 256;
+    float queue_start[QUEUE_SIZE];
+    float queue_end[QUEUE_SIZE];
+    int queue_head = 0;
+    int queue_count = 1;
+    queue_start[0] = 0;
+    queue_end[0] = 1;
+
+    float dx = x1 - x0;
+    float dy = y1 - y0;
+    while (queue_count > 0) {
+        float t_start = queue_start[queue_head];
+        float t_end = queue_end[queue_head];
+        queue_head = (queue_head + 1) % QUEUE_SIZE;
+        queue_count--;
+
+        float ax = x0 + dx * t_start, ay = y0 + dy * t_start;
+        float bx = x0 + dx * t_end, by = y0 + dy * t_end;
+        int min_x = floorf(fminf(ax, bx)), max_x = floorf(fmaxf(ax, bx));
+        int min_y = floorf(fminf(ay, by)), max_y = floorf(fmaxf(ay, by));
+        int level = 0;
+        while (level < occupancy_level_count - 1 && ((max_x >> level) - (min_x >> level) > 1 || (max_y >> level) - (min_y >> level) > 1)) {
+            level++;
+        }
+        if (!blocks_are_obstacle(level, min_x >> level, min_y >> level, max_x >> level, max_y >> level)) continue;
+
+        // small enough, or too many pieces waiting: walk this one pixel by pixel
+        if (level == 0 || queue_count + 2 > QUEUE_SIZE) {
+            GridTraversal2D cells(ax, ay, bx, by);
+            while (cells.next()) {
+                if (getPixelIsObstacle(cells.getX(), cells.getY())) return true;
+            }
+            continue;
+        }
+
+        float t_mid = (t_start + t_end) / 2;
+        if (getPixelIsObstacle(floorf(x0 + dx * t_mid), floorf(y0 + dy * t_mid))) return true;
+        int tail = (queue_head + queue_count) % QUEUE_SIZE;
+        queue_start[tail] = t_start;
+        queue_end[tail] = t_mid;
+        tail = (tail + 1) % QUEUE_SIZE;
+        queue_start[tail] = t_mid;
+        queue_end[tail] = t_end;
+        queue_count += 2;
+    }
+    return false;
+}
+
+// the border means a walk over an edge whose ends are inside the map never has to bounds check,
+// since the pixels it crosses are at most one past the map's edge.
+float* Map2D::getCostField(float cost_scale) {
+    for (std::pair<float, float*>& field : cost_fields) {
+        if (field.first == cost_scale) return field.second;
+    }
+    int size = cost_field_size();
+    float* field = (float*)malloc(size * sizeof(float));
+    for (int i = 0; i < size; i++) {
+        field[i] = INFINITY;
+    }
+    for (int height_pos = 0; height_pos < image_height; height_pos++) {
+        for (int width_pos = 0; width_pos < image_width; width_pos++) {
+            field[getCostOffset(width_pos, height_pos)] = 1.0f + (cost_scale * (1.0f - grayscale[grayoffset(width_pos, height_pos)]));
+        }
+    }
+    cost_fields.push_back(std::make_pair(cost_scale, field));
+    return field;
+}
+
+float* Map2D::getGradientField() {
+    if (gradient_field != nullptr) return gradient_field;
+    int size = (image_width + 2) * (image_height + 2);
+    gradient_field = (float*)malloc(size * 2 * sizeof(float));
+    for (int i = 0; i < size * 2; i++) {
+        gradient_field[i] = INFINITY;
+    }
+    for (int height_pos = 1; height_pos < image_height; height_pos++) {
+        for (int width_pos = 1; width_pos < image_width; width_pos++) {
+            float gray = grayscale[grayoffset(width_pos, height_pos)];
+            gradient_field[getCostOffset(width_pos, height_pos) * 2] = fabsf(gray - grayscale[grayoffset(width_pos - 1, height_pos)]);
+            gradient_field[getCostOffset(width_pos, height_pos) * 2 + 1] = fabsf(gray - grayscale[grayoffset(width_pos, height_pos - 1)]);
+        }
+    }
+    return gradient_field;
+}
+
+void Map2D::getCostSums(float cost_scale, double **row_sums, double **column_sums) {
+    for (int i = 0; i < (int)cost_row_sums.size(); i++) {
+        if (cost_row_sums[i].first == cost_scale) {
+            *row_sums = cost_row_sums[i].second;
+            *column_sums = cost_column_sums[i].second;
+            return;
+        }
+    }
+    float* field = getCostField(cost_scale);
+    *row_sums = (double*)malloc(row_sum_size() * sizeof(double));
+    *column_sums = (double*)malloc(column_sum_size() * sizeof(double));
+    for (int height_pos = 0; height_pos < image_height; height_pos++) {
+        double sum = 0;
+        for (int width_pos = 0; width_pos < image_width; width_pos++) {
+            (*row_sums)[getRowSumOffset(width_pos, height_pos)] = sum;
+            sum += field[getCostOffset(width_pos, height_pos)];
+        }
+        (*row_sums)[getRowSumOffset(image_width, height_pos)] = sum;
+    }
+    for (int width_pos = 0; width_pos < image_width; width_pos++) {
+        double sum = 0;
+        for (int height_pos = 0; height_pos < image_height; height_pos++) {
+            (*column_sums)[getColumnSumOffset(width_pos, height_pos)] = sum;
+            sum += field[getCostOffset(width_pos, height_pos)];
+        }
+        (*column_sums)[getColumnSumOffset(width_pos, image_height)] = sum;
+    }
+    cost_row_sums.push_back(std::make_pair(cost_scale, *row_sums));
+    cost_column_sums.push_back(std::make_pair(cost_scale, *column_sums));
+}
+
+int* Map2D::getObstacleRowCounts() {
+    if (obstacle_row_counts != nullptr) return obstacle_row_counts;
+    obstacle_row_counts = (int*)malloc(row_sum_size() * sizeof(int));
     for (int height_pos = 0; height_pos < image_height; height_pos++) {
-        png_bytep row = image_rows[height_pos];
+        int count = 0;
         for (int width_pos = 0; width_pos < image_width; width_pos++) {
-            png_bytep px = &(row[width_pos * 4]);
-            grayscale[grayoffset(width_pos, height_pos)] = ((int)px[0] + (int)px[1] + (int)px[2]) / 765.0f;
+            obstacle_row_counts[getRowSumOffset(width_pos, height_pos)] = count;
+            count += occupancy->get(width_pos, height_pos);
         }
+        obstacle_row_counts[getRowSumOffset(image_width, height_pos)] = count;
     }
+    return obstacle_row_counts;
+}
+
+int* Map2D::getObstacleColumnCounts() {
+    if (obstacle_column_counts != nullptr) return obstacle_column_counts;
+    obstacle_column_counts = (int*)malloc(column_sum_size() * sizeof(int));
+    for (int width_pos = 0; width_pos < image_width; width_pos++) {
+        int count = 0;
+        for (int height_pos = 0; height_pos < image_height; height_pos++) {
+            obstacle_column_counts[getColumnSumOffset(width_pos, height_pos)] = count;
+            count += occupancy->get(width_pos, height_pos);
+        }
+        obstacle_column_counts[getColumnSumOffset(width_pos, image_height)] = count;
+    }
+    return obstacle_column_counts;
+}
+
+///////////////////////////////////////////  MAP2D FILES  //////////////////////////////////////////////
+
+// grayscale, clearance, the occupancy levels and whichever cost fields, cost sums and obstacle counts have been made,
+// ready to map straight back into memory.  the cost layers depend on the cost_scale, so they're only saved for the ones
+// asked for before saving.
+void Map2D::saveMap2D(std::string filename) {
+    FILE* fp = fopen(filename.c_str(), "wb");
+    if (!fp) abort();
+
+    Map2DFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAP2D_FILE_MAGIC, sizeof(header.magic));
+    header.version = MAP2D_FILE_VERSION;
+    header.width = image_width;
+    header.height = image_height;
+    header.occupancy_level_count = occupancy_level_count;
+    header.cost_field_count = cost_fields.size();
+    header.cost_sum_count = cost_row_sums.size();
+    header.has_obstacle_counts = obstacle_row_counts != nullptr && obstacle_column_counts != nullptr;
+    header.content_hash = getContentHash();
+
+    size_t pixels = (size_t)image_width * image_height;
+    std::vector<std::pair<const void*, size_t>> layers;
+    layers.push_back(std::make_pair((const void*)grayscale, pixels * sizeof(float)));
+    layers.push_back(std::make_pair((const void*)clearance, pixels * sizeof(float)));
+    for (int level = 0; level < occupancy_level_count; level++) {
+        layers.push_back(std::make_pair((const void*)occupancy_levels[level]->getTiles(), occupancy_levels[level]->getTileCount() * sizeof(uint64_t)));
+    }
+    std::vector<float> cost_scales;
+    for (std::pair<float, float*>& field : cost_fields) cost_scales.push_back(field.first);
+    for (std::pair<float, double*>& sums : cost_row_sums) cost_scales.push_back(sums.first);
+    layers.push_back(std::make_pair((const void*)cost_scales.data(), cost_scales.size() * sizeof(float)));
+    for (std::pair<float, float*>& field : cost_fields) {
+        layers.push_back(std::make_pair((const void*)field.second, cost_field_size() * sizeof(float)));
+    }
+    for (int i = 0; i < header.cost_sum_count; i++) {
+        layers.push_back(std::make_pair((const void*)cost_row_sums[i].second, row_sum_size() * sizeof(double)));
+        layers.push_back(std::make_pair((const void*)cost_column_sums[i].second, column_sum_size() * sizeof(double)));
+    }
+    if (header.has_obstacle_counts) {
+        layers.push_back(std::make_pair((const void*)obstacle_row_counts, row_sum_size() * sizeof(int)));
+        layers.push_back(std::make_pair((const void*)obstacle_column_counts, column_sum_size() * sizeof(int)));
+    }
+
+    static const char padding[FILE_ALIGNMENT] = {0};
+    size_t offset = fwrite(&header, 1, sizeof(header), fp);
+    for (std::pair<const void*, size_t>& layer : layers) {
+        offset += fwrite(padding, 1, align_offset(offset) - offset, fp);
+        offset += fwrite(layer.first, 1, layer.second, fp);
+    }
+    if (offset != align_offset(offset)) {
+        offset += fwrite(padding, 1, align_offset(offset) - offset, fp);
+    }
+
+    fclose(fp);
+}
+
+// the layers are used in place, from a read only private mapping of the file, so loading only costs the page faults
+// of what the planner ends up touching.  for the same reason the content hash isn't checked against the grayscale
+// layer here, since that reads all of it; verifyContentHash() does that when it's wanted.
+void Map2D::load_map2d(std::string filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) abort();
+    struct stat sb;
+    if (fstat(fd, &sb) != 0) abort();
+    mapped_size = sb.st_size;
+    mapped_file = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped_file == MAP_FAILED) abort();
+
+    if (mapped_size < sizeof(Map2DFileHeader)) abort();
+    Map2DFileHeader* header = (Map2DFileHeader*)mapped_file;
+    if (memcmp(header->magic, MAP2D_FILE_MAGIC, sizeof(header->magic)) != 0) abort();
+    if (header->version != MAP2D_FILE_VERSION) abort();
+
+    if (header->width <= 0 || header->height <= 0 || header->occupancy_level_count < 1 ||
+        header->occupancy_level_count > 31 || header->cost_field_count < 0 || header->cost_sum_count < 0) abort();
+    // every cost layer takes more than its scale's float, so counts past this can't fit and aren't worth listing out
+    if ((size_t)header->cost_field_count + header->cost_sum_count > mapped_size / sizeof(float)) abort();
+
+    image_width = header->width;
+    image_height = header->height;
+    occupancy_level_count = header->occupancy_level_count;
+    content_hash = header->content_hash;
+
+    // where each layer starts, worked out from the header alone, so a truncated file is caught before any of it is read
+    size_t pixels = (size_t)image_width * image_height;
+    std::vector<size_t> sizes;
+    sizes.push_back(pixels * sizeof(float));
+    sizes.push_back(pixels * sizeof(float));
+    for (int level = 0; level < occupancy_level_count; level++) {
+        int level_width = (image_width + (1 << level) - 1) >> level;
+        int level_height = (image_height + (1 << level) - 1) >> level;
+        sizes.push_back(OccupancyBitmap::tileCount(level_width, level_height) * sizeof(uint64_t));
+    }
+    sizes.push_back(((size_t)header->cost_field_count + header->cost_sum_count) * sizeof(float));
+    for (int i = 0; i < header->cost_field_count; i++) {
+        sizes.push_back(cost_field_size() * sizeof(float));
+    }
+    for (int i = 0; i < header->cost_sum_count; i++) {
+        sizes.push_back(row_sum_size() * sizeof(double));
+        sizes.push_back(column_sum_size() * sizeof(double));
+    }
+    if (header->has_obstacle_counts) {
+        sizes.push_back(row_sum_size() * sizeof(int));
+        sizes.push_back(column_sum_size() * sizeof(int));
+    }
+    uint8_t* base = (uint8_t*)mapped_file;
+    std::vector<uint8_t*> layers;
+    size_t offset = sizeof(Map2DFileHeader);
+    for (size_t size : sizes) {
+        offset = align_offset(offset);
+        layers.push_back(base + offset);
+        offset += size;
+    }
+    if (offset > mapped_size) abort();
+
+    int layer = 0;
+    grayscale = (float*)layers[layer++];
+    clearance = (float*)layers[layer++];
+    occupancy_levels = (OccupancyBitmap**)malloc(occupancy_level_count * sizeof(OccupancyBitmap*));
+    for (int level = 0; level < occupancy_level_count; level++) {
+        int level_width = (image_width + (1 << level) - 1) >> level;
+        int level_height = (image_height + (1 << level) - 1) >> level;
+        occupancy_levels[level] = new OccupancyBitmap(level_width, level_height, (uint64_t*)layers[layer++]);
+    }
+    occupancy = occupancy_levels[0];
+
+    float* cost_scales = (float*)layers[layer++];
+    for (int i = 0; i < header->cost_field_count; i++) {
+        cost_fields.push_back(std::make_pair(cost_scales[i], (float*)layers[layer++]));
+    }
+    for (int i = 0; i < header->cost_sum_count; i++) {
+        float cost_scale = cost_scales[header->cost_field_count + i];
+        cost_row_sums.push_back(std::make_pair(cost_scale, (double*)layers[layer++]));
+        cost_column_sums.push_back(std::make_pair(cost_scale, (double*)layers[layer++]));
+    }
+    if (header->has_obstacle_counts) {
+        obstacle_row_counts = (int*)layers[layer++];
+        obstacle_column_counts = (int*)layers[layer++];
+    }
+}
+
+uint64_t Map2D::getContentHash() {
+    if (content_hash == 0) {
+        content_hash = compute_content_hash();
+    }
+    return content_hash;
+}
+
+// true if the grayscale layer still hashes to the content hash, e.g. the one a .map2d file was saved with
+bool Map2D::verifyContentHash() {
+    return compute_content_hash() == getContentHash();
+}
+
+uint64_t Map2D::compute_content_hash() {
+    return fnv1a_64(grayscale, (size_t)image_width * image_height * sizeof(float));
 }
 
 void Map2D::getBounds(State2D *minimums, State2D *maximums) {
     minimums->set(0, 0);
     maximums->set(image_width, image_height);
 }
-
-float Map2D::getGrayscalePixel(int width_pos, int height_pos) {
-    return grayscale[grayoffset(width_pos, height_pos)];
-}
@@ -2,13 +2,27 @@
 #define RRT_MAP2D_H
 
 #include "State2D.h"
+#include "OccupancyBitmap.h"
 #include <string>
+#include <cstdint>
+#include <vector>
+#include <utility>
 #include <png.h>
 
+// pixels darker than this are obstacles
+const float MAP2D_OBSTACLE_THRESHOLD = 0.01f;
+
+// maps preprocessed by saveMap2D() are loaded from files with this extension, anything else is decoded as a png
+const std::string MAP2D_FILE_EXTENSION = ".map2d";
+const uint32_t MAP2D_FILE_VERSION = 2;
+
 class Map2D {
 
 public:
-    Map2D(std::string pngfile);
+    Map2D(std::string filename);
+    void saveMap2D(std::string filename);
+    uint64_t getContentHash();
+    bool verifyContentHash();
     void getBounds(State2D* minimums, State2D* maximums);
     void configureVis(int width, int height);
     void resetVis();
@@ -17,23 +31,68 @@ public:
     void addGoalDetail(State2D* source, State2D* dest);
     void renderVis(std::string filename_prefix);
     void renderFinalVis(std::string filename_prefix);
-    float getGrayscalePixel(int width_pos, int height_pos);
+    inline float getGrayscalePixel(int width_pos, int height_pos) { return grayscale[grayoffset(width_pos, height_pos)]; }
+    inline bool getPixelIsObstacle(int width_pos, int height_pos) { return occupancy->get(width_pos, height_pos); }
+    inline float getClearance(int width_pos, int height_pos) { return clearance[grayoffset(width_pos, height_pos)]; }
+    inline bool getBlockIsObstacle(int level, int width_pos, int height_pos) { return occupancy_levels[level]->get(width_pos, height_pos); }
+    bool getSegmentIsObstacle(float x0, float y0, float x1, float y1);
+    float* getCostField(float cost_scale);
+    inline int getCostOffset(int width_pos, int height_pos) { return (height_pos + 1) * (image_width + 2) + width_pos + 1; }
+    float* getGradientField();
+    void getCostSums(float cost_scale, double** row_sums, double** column_sums);
+    int* getObstacleRowCounts();
+    int* getObstacleColumnCounts();
+    inline int getRowSumOffset(int width_pos, int height_pos) { return height_pos * (image_width + 1) + width_pos; }
+    inline int getColumnSumOffset(int width_pos, int height_pos) { return width_pos * (image_height + 1) + height_pos; }
     void addDebugText(std::string text);
 
 private:
     void load_png(std::string pngfile);
+    void load_map2d(std::string filename);
+    void make_vis();
     void write_png(std::string pngfile);
     void add_image_to_list(std::string filename_prefix);
     void write_video(std::string filename_prefix);
     void make_grayscale();
+    void make_occupancy();
+    void make_clearance();
+    void make_occupancy_levels();
+    bool blocks_are_obstacle(int level, int min_x, int min_y, int max_x, int max_y);
     inline int grayoffset(int width_pos, int height_pos) { return height_pos * image_width + width_pos; }
+    inline size_t cost_field_size() { return (size_t)(image_width + 2) * (image_height + 2); }
+    inline size_t row_sum_size() { return (size_t)(image_width + 1) * image_height; }
+    inline size_t column_sum_size() { return (size_t)image_width * (image_height + 1); }
+    uint64_t compute_content_hash();
 
     int image_width = 0;
     int image_height = 0;
     png_bytep *image_rows = NULL;
     png_bytep *vis_rows = NULL;
 
+    // set when the layers below point into a memory mapped .map2d file rather than their own allocations
+    void* mapped_file = nullptr;
+    size_t mapped_size = 0;
+    uint64_t content_hash = 0;
+
     float* grayscale = nullptr;
+    OccupancyBitmap* occupancy = nullptr;
+    // distance in pixels from each pixel to the nearest obstacle pixel, 0 on obstacles
+    float* clearance = nullptr;
+    // level k has one bit per 2^k x 2^k block of pixels, set if any pixel of the block is an obstacle.  level 0 is occupancy.
+    OccupancyBitmap** occupancy_levels = nullptr;
+    int occupancy_level_count = 0;
+    // 1 + cost_scale * (1 - grayscale) for each pixel, with a one pixel border of INFINITY.  one field per cost_scale asked for.
+    std::vector<std::pair<float, float*>> cost_fields;
+    // |grayscale - left neighbor| and |grayscale - upper neighbor| interleaved, laid out like the cost fields.
+    // pixels without both neighbors are INFINITY.
+    float* gradient_field = nullptr;
+    // prefix sums of the cost fields along each row and each column: entry n is the sum of the first n pixels.
+    // rows use getRowSumOffset, columns getColumnSumOffset, so each run is contiguous.  the obstacle counts are the same
+    // over occupancy.
+    std::vector<std::pair<float, double*>> cost_row_sums;
+    std::vector<std::pair<float, double*>> cost_column_sums;
+    int* obstacle_row_counts = nullptr;
+    int* obstacle_column_counts = nullptr;
     std::string filelist = "";
 
 };
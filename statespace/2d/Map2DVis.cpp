@@ -2,6 +2,7 @@
 #include <cstdint>
 #include <libgen.h>
 #include "Map2D.h"
+#include "GridTraversal2D.h"
 #include <iostream>
 #include <fstream>
 
@@ -10,7 +11,19 @@ void Map2D::configureVis(int width, int height) {
     // Map2D doesn't have a configurable output size
 }
 
+// the vis buffer is only made once something is drawn, since planning runs without vis don't need a copy of the image
+void Map2D::make_vis() {
+    size_t rowbytes = image_width * 4;
+    png_bytep pixels = (png_bytep)malloc(rowbytes * image_height);
+    vis_rows = (png_bytep*)malloc(sizeof(png_bytep) * image_height);
+    for (int height_pos = 0; height_pos < image_height; height_pos++) {
+        vis_rows[height_pos] = pixels + rowbytes * height_pos;
+    }
+    resetVis();
+}
+
 void Map2D::resetVis() {
+    if (!vis_rows) return;
     for (int height_pos = 0; height_pos < image_height; height_pos++) {
         png_bytep row = vis_rows[height_pos];
         for (int width_pos = 0; width_pos < image_width; width_pos++) {
@@ -39,6 +52,7 @@ void Map2D::addVisPoint(State2D *point, unsigned int color, bool big) {
     }
 
     else {
+        if (!vis_rows) make_vis();
         png_bytep row = vis_rows[(int) point->y];
         row[(int) point->x * 4 + 0] = (color >> 0) & 0x000000ff;
         row[(int) point->x * 4 + 1] = (color >> 8) & 0x000000ff;
@@ -49,10 +63,9 @@ void Map2D::addVisPoint(State2D *point, unsigned int color, bool big) {
 
 void Map2D::addVisLine(State2D *pointA, State2D *pointB, unsigned int color) {
     if (pointA == pointB) return;
-    State2D diff(pointB->x - pointA->x, pointB->y - pointA->y);
-    float step = 1.0f / hypotf(diff.x, diff.y);
-    for (float progress = 0; progress < 1; progress += step) {
-        State2D point(pointA->x + diff.x * progress, pointA->y + diff.y * progress);
+    GridTraversal2D cells(pointA->x, pointA->y, pointB->x, pointB->y);
+    while (cells.next()) {
+        State2D point(cells.getX(), cells.getY());
         addVisPoint(&point, color);
     }
 }
@@ -96,7 +109,7 @@ void Map2D::write_png(std::string filename_prefix) {
     );
     png_write_info(png, info);
 
-    if (!vis_rows) abort();
+    if (!vis_rows) make_vis();
 
     png_write_image(png, vis_rows);
     png_write_end(png, NULL);
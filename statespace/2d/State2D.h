@@ -8,6 +8,7 @@ class State2D {
 friend class State2DMath;
 friend class State2DElevationMath;
 friend class Map2D;
+template <class StateMath> friend class RRTPartitioned2D;
 
 public:
     State2D();
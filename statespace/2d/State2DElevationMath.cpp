@@ -1,5 +1,8 @@
 #include "State2DElevationMath.h"
+#include "GridTraversal2D.h"
 #include <cmath>
+#include <cfloat>
+#include <cstdlib>
 
 ///////////////////////////////////////////////  SETUP  //////////////////////////////////////////////////
 
@@ -13,9 +16,9 @@ State2DElevationMath::State2DElevationMath(float scale) {
 
 void State2DElevationMath::setMap(Map2D *_map) {
     map = _map;
-    State2D _minimums, _maximums;
-    map->getBounds(&_minimums, &_maximums);
-    setRandomStateConstraints(_minimums, _maximums);
+    map->getBounds(&map_minimums, &map_maximums);
+    setRandomStateConstraints(map_minimums, map_maximums);
+    gradient_field = map->getGradientField();
 }
 
 void State2DElevationMath::setCostScale(float scale) {
@@ -25,53 +28,99 @@ void State2DElevationMath::setCostScale(float scale) {
 ////////////////////////////////////////  OBSTACLE DETECTION  ////////////////////////////////////////////
 
 bool State2DElevationMath::pointInObstacle(State2D *point) {
-    return map->getGrayscalePixel(point->x, point->y) < 0.01;
+    return map->getPixelIsObstacle(point->x, point->y);
 }
 
+// walks every pixel the edge crosses, but only looks up the ones that could be obstacles.
+// no obstacle is within the clearance of a pixel, and any point of that pixel is less than sqrt(2) from any other,
+// so the edge is clear for clearance - sqrt(2) past the point where it entered the pixel.
 bool State2DElevationMath::edgeInObstacle(State2D *pointA, State2D *pointB) {
-    State2D diff(pointB->x - pointA->x, pointB->y - pointA->y);
-    float step = EDGE_WALK_SCALE / hypotf(diff.x, diff.y);
-    for (float progress = 0; progress < 1; progress += step) {
-        State2D point(pointA->x + diff.x * progress, pointA->y + diff.y * progress);
-        if (pointInObstacle(&point)) {
+    if (bisection_checking) {
+        return map->getSegmentIsObstacle(pointA->x, pointA->y, pointB->x, pointB->y);
+    }
+    GridTraversal2D cells(pointA->x, pointA->y, pointB->x, pointB->y);
+    while (cells.next()) {
+        if (map->getPixelIsObstacle(cells.getX(), cells.getY())) {
             return true;
         }
+        cells.skip(map->getClearance(cells.getX(), cells.getY()) - CLEARANCE_MARGIN);
     }
     return false;
 }
 
+// check edges coarse to fine over the map's occupancy levels instead of walking them from the source
+void State2DElevationMath::setBisectionChecking(bool _enabled) {
+    bisection_checking = _enabled;
+}
+
 /////////////////////////////////////////  COST CALCULATIONS  ////////////////////////////////////////////
 
 float State2DElevationMath::pointCost(State2D *point, float heading) {
     int x = point->x;
     int y = point->y;
-    if (x < 1 || x >= maximums.x || y < 1 || y >= maximums.y) {
+    if (x < 1 || x >= map_maximums.x || y < 1 || y >= map_maximums.y) {
         return INFINITY;
     }
     else {
-        float dx = map->getGrayscalePixel(x, y) - map->getGrayscalePixel(x-1, y);
-        float dy = map->getGrayscalePixel(x, y) - map->getGrayscalePixel(x, y-1);
-        float costx = fabsf(dx * cosf(heading));
-        float costy = fabsf(dy * sinf(heading));
-        return 1.0f + (cost_scale * (costx + costy));
+        float* gradient = &gradient_field[map->getCostOffset(x, y) * 2];
+        return 1.0f + (cost_scale * (gradient[0] * fabsf(cosf(heading)) + gradient[1] * fabsf(sinf(heading))));
     }
 }
 
+// the heading is the same along the whole edge, so its trig is done once, scaled by cost_scale.
+// the weights are kept above zero so an INFINITY gradient still gives an INFINITY cost on axis aligned edges.
+void State2DElevationMath::heading_weights(State2D *source, State2D *dest, float *weight_x, float *weight_y) {
+    float heading = atan2f(dest->y-source->y, dest->x-source->x);
+    *weight_x = fmaxf(cost_scale * fabsf(cosf(heading)), FLT_MIN);
+    *weight_y = fmaxf(cost_scale * fabsf(sinf(heading)), FLT_MIN);
+}
+
+// the integral of pointCost along the edge: each crossed pixel's cost, times the length of edge inside it.
+// like State2DMath, ends inside the map keep the walk within the padded gradient field.
 float State2DElevationMath::edgeCost(State2D *pointA, State2D *pointB, State2D *pointB_updated) {
-    float sum = 0;
-    State2D diff(pointB->x - pointA->x, pointB->y - pointA->y);
-    int iterations = 0;
-    float length = hypotf(diff.x, diff.y);
-    float heading = atan2f(pointB->y-pointA->y, pointB->x-pointA->x);
-    for (float progress = 0; progress < 1; progress += EDGE_WALK_SCALE / length) {
-        State2D point(pointA->x + diff.x * progress, pointA->y + diff.y * progress);
-        sum += pointCost(&point, heading);
-        iterations++;
-    }
     if (pointB_updated != nullptr) {
         *pointB_updated = *pointB;
     }
-    return iterations == 0 ? 0 : sum / iterations * length;
+    if (outside_map(pointA) || outside_map(pointB)) return INFINITY;
+    float weight_x, weight_y;
+    heading_weights(pointA, pointB, &weight_x, &weight_y);
+    float sum = 0;
+    GridTraversal2D cells(pointA->x, pointA->y, pointB->x, pointB->y);
+    while (cells.next()) {
+        float length = cells.getLength();
+        float* gradient = &gradient_field[map->getCostOffset(cells.getX(), cells.getY()) * 2];
+        float cost = 1.0f + gradient[0] * weight_x + gradient[1] * weight_y;
+        sum += length > 0 ? cost * length : 0;
+    }
+    return sum;
+}
+
+// edgeInObstacle and edgeCost in one walk.  every pixel is visited anyway for the cost, so there's no clearance skipping.
+EdgeEvaluation<State2D> State2DElevationMath::evaluateEdge(State2D *source, State2D *dest) {
+    EdgeEvaluation<State2D> result;
+    result.collides = false;
+    result.cost = 0;
+    result.dest = *dest;
+    if (outside_map(source) || outside_map(dest)) {
+        result.collides = true;
+        result.cost = INFINITY;
+        return result;
+    }
+    float weight_x, weight_y;
+    heading_weights(source, dest, &weight_x, &weight_y);
+    GridTraversal2D cells(source->x, source->y, dest->x, dest->y);
+    while (cells.next()) {
+        if (map->getPixelIsObstacle(cells.getX(), cells.getY())) {
+            result.collides = true;
+            result.cost = INFINITY;
+            return result;
+        }
+        float length = cells.getLength();
+        float* gradient = &gradient_field[map->getCostOffset(cells.getX(), cells.getY()) * 2];
+        float cost = 1.0f + gradient[0] * weight_x + gradient[1] * weight_y;
+        result.cost += length > 0 ? cost * length : 0;
+    }
+    return result;
 }
 
 ///////////////////////////////////////  DISTANCE CALCULATIONS  //////////////////////////////////////////
@@ -87,6 +136,11 @@ double State2DElevationMath::approx_distance(State2D* a, State2D* b) {
     return fabs(a->x - b->x) + fabs(a->y - b->y);
 }
 
+// same bound as State2DMath::costToGo(), the elevation terms only add to the cost
+float State2DElevationMath::costToGo(State2D* source, State2D* dest) {
+    return 0.999f * distance(source, dest);
+}
+
 ////////////////////////////////////////// SAMPLE GENERATION /////////////////////////////////////////////
 
 void State2DElevationMath::setRandomStateConstraints(State2D _minimums, State2D _maximums) {
@@ -99,9 +153,13 @@ void State2DElevationMath::setRandomStateConstraints(State2D _minimums, State2D
     shift.y = minimums.y;
 }
 
+void State2DElevationMath::setRandomSeed(unsigned int seed) {
+    random_seed = seed;
+}
+
 State2D State2DElevationMath::getRandomState() {
     State2D output;
-    output.x = (double)rand() * scale.x + shift.x;
-    output.y = (double)rand() * scale.y + shift.y;
+    output.x = (double)rand_r(&random_seed) * scale.x + shift.x;
+    output.y = (double)rand_r(&random_seed) * scale.y + shift.y;
     return output;
 }
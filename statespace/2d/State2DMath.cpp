@@ -1,5 +1,7 @@
 #include "State2DMath.h"
+#include "GridTraversal2D.h"
 #include <cmath>
+#include <cstdlib>
 
 ///////////////////////////////////////////////  SETUP  //////////////////////////////////////////////////
 
@@ -13,60 +15,194 @@ State2DMath::State2DMath(float scale) {
 
 void State2DMath::setMap(Map2D *_map) {
     map = _map;
-    State2D _minimums, _maximums;
-    map->getBounds(&_minimums, &_maximums);
-    setRandomStateConstraints(_minimums, _maximums);
+    map->getBounds(&map_minimums, &map_maximums);
+    setRandomStateConstraints(map_minimums, map_maximums);
+    cost_field = map->getCostField(cost_scale);
+    load_runs();
 }
 
 void State2DMath::setCostScale(float _scale) {
     cost_scale = _scale;
+    if (map != nullptr) {
+        cost_field = map->getCostField(cost_scale);
+        load_runs();
+    }
+}
+
+// cost and check edges within one row or one column of pixels from prefix sums over the map.  that pays off for grid
+// and lattice planners, but the sums take 24 bytes a pixel, so it's off unless asked for.
+void State2DMath::setRunLookups(bool _enabled) {
+    run_lookups = _enabled;
+    load_runs();
+}
+
+void State2DMath::load_runs() {
+    if (!run_lookups || map == nullptr) return;
+    map->getCostSums(cost_scale, &row_sums, &column_sums);
+    obstacle_row_counts = map->getObstacleRowCounts();
+    obstacle_column_counts = map->getObstacleColumnCounts();
 }
 
 ////////////////////////////////////////  OBSTACLE DETECTION  ////////////////////////////////////////////
 
 bool State2DMath::pointInObstacle(State2D *point) {
-    return map->getGrayscalePixel(point->x, point->y) < 0.01;
+    return map->getPixelIsObstacle(point->x, point->y);
 }
 
+// walks every pixel the edge crosses, but only looks up the ones that could be obstacles.
+// no obstacle is within the clearance of a pixel, and any point of that pixel is less than sqrt(2) from any other,
+// so the edge is clear for clearance - sqrt(2) past the point where it entered the pixel.
 bool State2DMath::edgeInObstacle(State2D *pointA, State2D *pointB) {
-    State2D diff(pointB->x - pointA->x, pointB->y - pointA->y);
-    float step = EDGE_WALK_SCALE / hypotf(diff.x, diff.y);
-    for (float progress = 0; progress < 1; progress += step) {
-        State2D point(pointA->x + diff.x * progress, pointA->y + diff.y * progress);
-        if (pointInObstacle(&point)) {
+    bool horizontal;
+    int line;
+    float start, end;
+    if (find_run(pointA, pointB, &horizontal, &line, &start, &end)) {
+        return run_in_obstacle(horizontal, line, start, end);
+    }
+    if (bisection_checking) {
+        return map->getSegmentIsObstacle(pointA->x, pointA->y, pointB->x, pointB->y);
+    }
+    GridTraversal2D cells(pointA->x, pointA->y, pointB->x, pointB->y);
+    while (cells.next()) {
+        if (map->getPixelIsObstacle(cells.getX(), cells.getY())) {
             return true;
         }
+        cells.skip(map->getClearance(cells.getX(), cells.getY()) - CLEARANCE_MARGIN);
     }
     return false;
 }
 
+// check edges coarse to fine over the map's occupancy levels instead of walking them from the source
+void State2DMath::setBisectionChecking(bool _enabled) {
+    bisection_checking = _enabled;
+}
+
 /////////////////////////////////////////  COST CALCULATIONS  ////////////////////////////////////////////
 
 float State2DMath::pointCost(State2D *point) {
     int x = point->x;
     int y = point->y;
-    if (x < 0 || x >= maximums.x || y < 0 || y >= maximums.y) {
+    if (x < 0 || x >= map_maximums.x || y < 0 || y >= map_maximums.y) {
         return INFINITY;
     }
     else {
-        return 1.0f + (cost_scale * (1.0f - map->getGrayscalePixel(x, y)));
+        return cost_field[map->getCostOffset(x, y)];
     }
 }
 
+// the integral of pointCost along the edge: each crossed pixel's cost, times the length of edge inside it.
+// an end outside the map puts part of the edge outside too, which costs INFINITY.  otherwise the padded cost field
+// covers every pixel the walk can touch, and the zero length touches at pixel corners are selected away rather than
+// multiplied, since INFINITY * 0 is nan.
 float State2DMath::edgeCost(State2D *pointA, State2D *pointB, State2D *pointB_updated) {
-    float sum = 0;
-    State2D diff(pointB->x - pointA->x, pointB->y - pointA->y);
-    int iterations = 0;
-    float length = hypotf(diff.x, diff.y);
-    for (float progress = 0; progress < 1; progress += EDGE_WALK_SCALE / length) {
-        State2D point(pointA->x + diff.x * progress, pointA->y + diff.y * progress);
-        sum += pointCost(&point);
-        iterations++;
-    }
     if (pointB_updated != nullptr) {
         *pointB_updated = *pointB;
     }
-    return iterations == 0 ? 0 : sum / iterations * length;
+    if (outside_map(pointA) || outside_map(pointB)) return INFINITY;
+    bool horizontal;
+    int line;
+    float start, end;
+    if (find_run(pointA, pointB, &horizontal, &line, &start, &end)) {
+        return run_cost(pointA, pointB, horizontal, line, start, end);
+    }
+    float sum = 0;
+    GridTraversal2D cells(pointA->x, pointA->y, pointB->x, pointB->y);
+    while (cells.next()) {
+        float length = cells.getLength();
+        float cost = cost_field[map->getCostOffset(cells.getX(), cells.getY())];
+        sum += length > 0 ? cost * length : 0;
+    }
+    return sum;
+}
+
+// edgeInObstacle and edgeCost in one walk.  every pixel is visited anyway for the cost, so there's no clearance skipping.
+EdgeEvaluation<State2D> State2DMath::evaluateEdge(State2D *source, State2D *dest) {
+    EdgeEvaluation<State2D> result;
+    result.collides = false;
+    result.cost = 0;
+    result.dest = *dest;
+    if (outside_map(source) || outside_map(dest)) {
+        result.collides = true;
+        result.cost = INFINITY;
+        return result;
+    }
+    bool horizontal;
+    int line;
+    float start, end;
+    if (find_run(source, dest, &horizontal, &line, &start, &end)) {
+        result.collides = run_in_obstacle(horizontal, line, start, end);
+        result.cost = result.collides ? INFINITY : run_cost(source, dest, horizontal, line, start, end);
+        return result;
+    }
+    GridTraversal2D cells(source->x, source->y, dest->x, dest->y);
+    while (cells.next()) {
+        if (map->getPixelIsObstacle(cells.getX(), cells.getY())) {
+            result.collides = true;
+            result.cost = INFINITY;
+            return result;
+        }
+        float length = cells.getLength();
+        float cost = cost_field[map->getCostOffset(cells.getX(), cells.getY())];
+        result.cost += length > 0 ? cost * length : 0;
+    }
+    return result;
+}
+
+////////////////////////////////////////////  PIXEL RUNS  ///////////////////////////////////////////////
+
+// an edge that stays within one row of pixels crosses a run of them along that row, and likewise for columns.
+// grid and lattice moves mostly do, and so do many short edges.  their costs and obstacle checks come from the map's
+// prefix sums in constant time.  false when the edge needs a walk, including runs touching the map's far edges, and
+// always when run lookups are off.
+bool State2DMath::find_run(State2D *pointA, State2D *pointB, bool *horizontal, int *line, float *start, float *end) {
+    if (!run_lookups || row_sums == nullptr) return false;
+    int row = floorf(pointA->y);
+    int column = floorf(pointA->x);
+    if (row == (int)floorf(pointB->y) && pointA->x != pointB->x) {
+        *horizontal = true;
+        *line = row;
+        *start = fminf(pointA->x, pointB->x);
+        *end = fmaxf(pointA->x, pointB->x);
+    }
+    else if (column == (int)floorf(pointB->x) && pointA->y != pointB->y) {
+        *horizontal = false;
+        *line = column;
+        *start = fminf(pointA->y, pointB->y);
+        *end = fmaxf(pointA->y, pointB->y);
+    }
+    else {
+        return false;
+    }
+    int lines = *horizontal ? map_maximums.y : map_maximums.x;
+    int run_length = *horizontal ? map_maximums.x : map_maximums.y;
+    return *line >= 0 && *line < lines && *start >= 0 && floorf(*end) < run_length;
+}
+
+// the integral of pixel cost along the run, from its start to position
+double State2DMath::run_integral(bool horizontal, int line, float position) {
+    int pixel = floorf(position);
+    if (horizontal) {
+        return row_sums[map->getRowSumOffset(pixel, line)] + cost_field[map->getCostOffset(pixel, line)] * (position - pixel);
+    }
+    return column_sums[map->getColumnSumOffset(line, pixel)] + cost_field[map->getCostOffset(line, pixel)] * (position - pixel);
+}
+
+// the edge covers length / (end - start) along itself for each pixel of length it covers along the run
+float State2DMath::run_cost(State2D *pointA, State2D *pointB, bool horizontal, int line, float start, float end) {
+    double length = hypot(pointB->x - pointA->x, pointB->y - pointA->y);
+    return (run_integral(horizontal, line, end) - run_integral(horizontal, line, start)) * (length / (end - start));
+}
+
+// every pixel the closed run touches, so an end exactly on a pixel border also counts the pixel past it.
+// that's a superset of what the walk looks at whichever way it goes.
+bool State2DMath::run_in_obstacle(bool horizontal, int line, float start, float end) {
+    int first = ceilf(start) - 1;
+    int last = floorf(end);
+    if (first < 0) return true;
+    if (horizontal) {
+        return obstacle_row_counts[map->getRowSumOffset(last + 1, line)] - obstacle_row_counts[map->getRowSumOffset(first, line)] > 0;
+    }
+    return obstacle_column_counts[map->getColumnSumOffset(line, last + 1)] - obstacle_column_counts[map->getColumnSumOffset(line, first)] > 0;
 }
 
 ///////////////////////////////////////  DISTANCE CALCULATIONS  //////////////////////////////////////////
@@ -82,6 +218,12 @@ double State2DMath::approx_distance(State2D* source, State2D* dest) {
     return fabs(dest->x - source->x) + fabs(dest->y - source->y);
 }
 
+// admissible estimate of the cost from source to dest.  every point costs at least 1, so the straight line distance
+// is a lower bound; it's shaved slightly so float rounding in edgeCost() can't push it past the real cost.
+float State2DMath::costToGo(State2D* source, State2D* dest) {
+    return 0.999f * distance(source, dest);
+}
+
 ////////////////////////////////////////// SAMPLE GENERATION /////////////////////////////////////////////
 
 void State2DMath::setRandomStateConstraints(State2D _minimums, State2D _maximums) {
@@ -94,9 +236,13 @@ void State2DMath::setRandomStateConstraints(State2D _minimums, State2D _maximums
     shift.y = minimums.y;
 }
 
+void State2DMath::setRandomSeed(unsigned int seed) {
+    random_seed = seed;
+}
+
 State2D State2DMath::getRandomState() {
     State2D output;
-    output.x = (double)rand() * scale.x + shift.x;
-    output.y = (double)rand() * scale.y + shift.y;
+    output.x = (double)rand_r(&random_seed) * scale.x + shift.x;
+    output.y = (double)rand_r(&random_seed) * scale.y + shift.y;
     return output;
 }
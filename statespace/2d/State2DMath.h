@@ -3,6 +3,7 @@
 
 #include "State2D.h"
 #include "Map2D.h"
+#include "EdgeEvaluation.h"
 
 class State2DMath {
   
@@ -15,23 +16,45 @@ public:
 
     bool pointInObstacle(State2D* point);
     bool edgeInObstacle(State2D* pointA, State2D* pointB);
+    void setBisectionChecking(bool _enabled);
+    void setRunLookups(bool _enabled);
 
     float pointCost(State2D* point);
     float edgeCost(State2D* pointA, State2D* pointB, State2D* pointB_updated=nullptr);
+    EdgeEvaluation<State2D> evaluateEdge(State2D* source, State2D* dest);
 
     double distance(State2D* source, State2D* dest);
     double approx_distance(State2D* source, State2D* dest);
+    float costToGo(State2D* source, State2D* dest);
 
     void setRandomStateConstraints(State2D _minimums, State2D _maximums);
+    void setRandomSeed(unsigned int seed);
     State2D getRandomState();
 
 protected:
+    inline bool outside_map(State2D* point) { return point->x < 0 || point->x > map_maximums.x || point->y < 0 || point->y > map_maximums.y; }
+    void load_runs();
+    bool find_run(State2D* pointA, State2D* pointB, bool* horizontal, int* line, float* start, float* end);
+    double run_integral(bool horizontal, int line, float position);
+    float run_cost(State2D* pointA, State2D* pointB, bool horizontal, int line, float start, float end);
+    bool run_in_obstacle(bool horizontal, int line, float start, float end);
+
     State2D minimums, maximums;
+    State2D map_minimums, map_maximums;
     State2D scale, shift;
+    unsigned int random_seed = 1;
 
     float cost_scale = 1;
-
-    const float EDGE_WALK_SCALE = 1.0f;
+    float* cost_field = nullptr;
+    double* row_sums = nullptr;
+    double* column_sums = nullptr;
+    int* obstacle_row_counts = nullptr;
+    int* obstacle_column_counts = nullptr;
+    bool bisection_checking = false;
+    bool run_lookups = false;
+
+    // sqrt(2) across a pixel, plus slack for float error
+    const float CLEARANCE_MARGIN = 1.5f;
 
     Map2D* map = nullptr;
 };
@@ -0,0 +1,55 @@
+#include "GridTraversal3D.h"
+#include <cmath>
+
+GridTraversal3D::GridTraversal3D(double _x0, double _y0, double _z0, double _x1, double _y1, double _z1) {
+    x0 = _x0;
+    y0 = _y0;
+    z0 = _z0;
+    dx = _x1 - _x0;
+    dy = _y1 - _y0;
+    dz = _z1 - _z0;
+    length = sqrt(dx * dx + dy * dy + dz * dz);
+    step_x = dx > 0 ? 1 : (dx < 0 ? -1 : 0);
+    step_y = dy > 0 ? 1 : (dy < 0 ? -1 : 0);
+    step_z = dz > 0 ? 1 : (dz < 0 ? -1 : 0);
+    t_delta_x = dx != 0 ? 1.0 / fabs(dx) : INFINITY;
+    t_delta_y = dy != 0 ? 1.0 / fabs(dy) : INFINITY;
+    t_delta_z = dz != 0 ? 1.0 / fabs(dz) : INFINITY;
+    start_at(0);
+}
+
+// the next voxel is the one containing the point at t.  voxel boundaries are measured from the segment's origin,
+// so restarting part way along doesn't accumulate any error.
+void GridTraversal3D::start_at(double t) {
+    x = (int)floor(x0 + dx * t);
+    y = (int)floor(y0 + dy * t);
+    z = (int)floor(z0 + dz * t);
+    t_max_x = step_x > 0 ? (x + 1 - x0) / dx : (step_x < 0 ? (x - x0) / dx : INFINITY);
+    t_max_y = step_y > 0 ? (y + 1 - y0) / dy : (step_y < 0 ? (y - y0) / dy : INFINITY);
+    t_max_z = step_z > 0 ? (z + 1 - z0) / dz : (step_z < 0 ? (z - z0) / dz : INFINITY);
+    t_enter = t;
+    started = false;
+}
+
+// jump ahead so the next voxel is the first one past the aligned block of 2^bits voxels per side holding the current
+// one.  returns the length of the segment from where the current voxel was entered to where it leaves the block.
+// if rounding puts the restart back inside the block, the next call only covers the current voxel and next() carries on
+// one voxel at a time.
+float GridTraversal3D::leaveBlock(int bits) {
+    int size = 1 << bits;
+    int block_x = (x >> bits) << bits;
+    int block_y = (y >> bits) << bits;
+    int block_z = (z >> bits) << bits;
+    double t_x = step_x > 0 ? (block_x + size - x0) / dx : (step_x < 0 ? (block_x - x0) / dx : INFINITY);
+    double t_y = step_y > 0 ? (block_y + size - y0) / dy : (step_y < 0 ? (block_y - y0) / dy : INFINITY);
+    double t_z = step_z > 0 ? (block_z + size - z0) / dz : (step_z < 0 ? (block_z - z0) / dz : INFINITY);
+    double t = fmin(t_x, fmin(t_y, t_z));
+    if (t >= 1) {
+        finished = true;
+        return (1 - t_enter) * length;
+    }
+    if (!(t > t_exit)) return getLength();
+    float covered = (t - t_enter) * length;
+    start_at(t);
+    return covered;
+}
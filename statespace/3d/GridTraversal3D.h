@@ -0,0 +1,64 @@
+#ifndef GRIDTRAVERSAL3D_H
+#define GRIDTRAVERSAL3D_H
+
+// Walks the voxels crossed by a line segment, in order, visiting each one exactly once. (Amanatides & Woo)
+// Voxel (x, y, z) covers [x, x+1) x [y, y+1) x [z, z+1).  Coordinates are in voxels, so callers scale world
+// coordinates by the voxel size first.
+//
+//   GridTraversal3D cells(a.x, a.y, a.z, b.x, b.y, b.z);
+//   while (cells.next()) { ... cells.getX(), cells.getY(), cells.getZ(), cells.getLength() ... }
+
+class GridTraversal3D {
+
+public:
+    GridTraversal3D(double _x0, double _y0, double _z0, double _x1, double _y1, double _z1);
+    float leaveBlock(int bits);
+
+    // moves to the next voxel, returns false once the segment is used up
+    inline bool next() {
+        if (finished) return false;
+        if (started) {
+            int axis = t_max_x < t_max_y ? (t_max_x < t_max_z ? 0 : 2) : (t_max_y < t_max_z ? 1 : 2);
+            x += axis == 0 ? step_x : 0;
+            y += axis == 1 ? step_y : 0;
+            z += axis == 2 ? step_z : 0;
+            t_enter = axis == 0 ? t_max_x : (axis == 1 ? t_max_y : t_max_z);
+            t_max_x += axis == 0 ? t_delta_x : 0;
+            t_max_y += axis == 1 ? t_delta_y : 0;
+            t_max_z += axis == 2 ? t_delta_z : 0;
+            if (t_enter >= 1) {
+                finished = true;
+                return false;
+            }
+        }
+        started = true;
+        t_exit = t_max_x < t_max_y ? t_max_x : t_max_y;
+        if (t_max_z < t_exit) t_exit = t_max_z;
+        if (t_exit > 1) t_exit = 1;
+        return true;
+    }
+
+    inline int getX() { return x; }
+    inline int getY() { return y; }
+    inline int getZ() { return z; }
+
+    // length of the segment inside the current voxel
+    inline float getLength() { return (t_exit - t_enter) * length; }
+
+private:
+    void start_at(double t);
+
+    double x0, y0, z0, dx, dy, dz;
+    float length = 0;
+
+    int x = 0, y = 0, z = 0;
+    int step_x = 0, step_y = 0, step_z = 0;
+    // t runs from 0 at the start of the segment to 1 at the end
+    double t_delta_x = 0, t_delta_y = 0, t_delta_z = 0;
+    double t_max_x = 0, t_max_y = 0, t_max_z = 0;
+    double t_enter = 0, t_exit = 0;
+    bool started = false;
+    bool finished = false;
+};
+
+#endif
@@ -1,23 +1,774 @@
 #include "Map3D.h"
+#include "GridTraversal3D.h"
+#include "utils.h"
 #include <cstdio>
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
+// the arrays follow the header in this order, each starting on a FILE_ALIGNMENT boundary: the objects in BVH leaf
+// order, the BVH nodes, the object blocks, the bricks and the brick table.
+// content_hash is fnv1a_64 of the border, the voxel size, the objects and the bricks, which the rest is made from.
+struct Map3DFileHeader {
+    char magic[8];
+    uint32_t version;
+    int32_t object_count;
+    int32_t bvh_node_count;
+    int32_t object_block_count;
+    int32_t brick_count;
+    int32_t brick_table_size;
+    float voxel_size;
+    float minimum_cost;
+    double border[6];
+    uint64_t content_hash;
+};
+
+static const char MAP3D_FILE_MAGIC[8] = {'R', 'R', 'T', 'M', 'A', 'P', '3', 'D'};
+static const size_t FILE_ALIGNMENT = 64;
+
+static size_t align_offset(size_t offset) {
+    return (offset + FILE_ALIGNMENT - 1) / FILE_ALIGNMENT * FILE_ALIGNMENT;
+}
+
+// box maps list the border's lower and upper corners, then one "x y z size_x size_y size_z" line per box.
+// voxel maps start with the word "voxels", then the border corners, the voxel size, and one "x y z cost" line per
+// voxel, with integer voxel coordinates.  voxel (x, y, z) covers [x, x+1) * voxel_size on each axis.  a cost of inf
+// makes the voxel an obstacle, and voxels that aren't listed cost 1.
 Map3D::Map3D(std::string datafile) {
+    if (datafile.size() >= MAP3D_FILE_EXTENSION.size() &&
+        datafile.compare(datafile.size() - MAP3D_FILE_EXTENSION.size(), MAP3D_FILE_EXTENSION.size(), MAP3D_FILE_EXTENSION) == 0) {
+        load_map3d(datafile);
+        return;
+    }
     FILE* fp;
     fp = fopen(datafile.c_str(), "r");
     if (fp != NULL) {
-        fscanf(fp, "%lf %lf %lf", &border.bound_lower.x, &border.bound_lower.y, &border.bound_lower.z);
-        fscanf(fp, "%lf %lf %lf", &border.bound_upper.x, &border.bound_upper.y, &border.bound_upper.z);
-        while (!feof(fp)) {
-            fscanf(fp, "%lf %lf %lf", &objects[object_count].bound_lower.x, &objects[object_count].bound_lower.y, &objects[object_count].bound_lower.z);
-            State3D size;
-            fscanf(fp, "%lf %lf %lf", &size.x, &size.y, &size.z);
-            objects[object_count].bound_upper.x = objects[object_count].bound_lower.x + size.x;
-            objects[object_count].bound_upper.y = objects[object_count].bound_lower.y + size.y;
-            objects[object_count].bound_upper.z = objects[object_count].bound_lower.z + size.z;
-            object_count++;
+        char format[16] = {0};
+        if (fscanf(fp, "%15s", format) == 1 && strcmp(format, "voxels") == 0) {
+            load_voxels(fp);
+        } else {
+            rewind(fp);
+            load_boxes(fp);
         }
         fclose(fp);
     }
+    make_bvh();
+}
+
+Map3D::~Map3D() {
+    free(distance_field);
+    if (mapped_file != nullptr) {
+        munmap(mapped_file, mapped_size);
+        return;
+    }
+    free(objects);
+    free(bvh_nodes);
+    free(object_blocks);
+    free(bricks);
+    free(brick_table);
+}
+
+void Map3D::load_boxes(FILE *fp) {
+    fscanf(fp, "%lf %lf %lf", &border.bound_lower.x, &border.bound_lower.y, &border.bound_lower.z);
+    fscanf(fp, "%lf %lf %lf", &border.bound_upper.x, &border.bound_upper.y, &border.bound_upper.z);
+    Map3DObject object;
+    State3D size;
+    while (fscanf(fp, "%lf %lf %lf %lf %lf %lf", &object.bound_lower.x, &object.bound_lower.y, &object.bound_lower.z,
+                  &size.x, &size.y, &size.z) == 6) {
+        object.bound_upper.x = object.bound_lower.x + size.x;
+        object.bound_upper.y = object.bound_lower.y + size.y;
+        object.bound_upper.z = object.bound_lower.z + size.z;
+        add_object(&object);
+    }
+}
+
+void Map3D::load_voxels(FILE *fp) {
+    fscanf(fp, "%lf %lf %lf", &border.bound_lower.x, &border.bound_lower.y, &border.bound_lower.z);
+    fscanf(fp, "%lf %lf %lf", &border.bound_upper.x, &border.bound_upper.y, &border.bound_upper.z);
+    fscanf(fp, "%f", &voxel_size);
+    int x, y, z;
+    float cost;
+    while (fscanf(fp, "%d %d %d %f", &x, &y, &z, &cost) == 4) {
+        set_voxel(x, y, z, cost);
+    }
+}
+
+void Map3D::add_object(Map3DObject *object) {
+    if (object_count == object_capacity) {
+        object_capacity = object_capacity == 0 ? 64 : object_capacity * 2;
+        objects = (Map3DObject*)realloc(objects, object_capacity * sizeof(Map3DObject));
+    }
+    objects[object_count++] = *object;
+}
+
+int Map3D::getObjectCount() {
+    return object_count;
+}
+
+int Map3D::getBrickCount() {
+    return brick_count;
+}
+
+float Map3D::getVoxelSize() {
+    return voxel_size;
+}
+
+// the lowest cost per unit length anywhere on the map, for admissible cost estimates
+float Map3D::getMinimumCost() {
+    return minimum_cost;
+}
+
+////////////////////////////////////////////  OBSTACLES AND COST  ////////////////////////////////////////////
+
+bool Map3D::pointInObstacle(State3D *point) {
+    if (point_in_objects(point)) return true;
+    return brick_count > 0 && point_voxel_cost(point) == INFINITY;
+}
+
+// the part of the edge the distance field shows is clear is skipped, and the rest tested exactly
+bool Map3D::edgeInObstacle(State3D *pointA, State3D *pointB) {
+    double t_clear = trace_edge(pointA, pointB);
+    if (t_clear >= 1) return false;
+    if (edge_in_objects(pointA, pointB, t_clear)) return true;
+    if (brick_count == 0) return false;
+    State3D rest(pointA->x + (pointB->x - pointA->x) * t_clear, pointA->y + (pointB->y - pointA->y) * t_clear,
+                 pointA->z + (pointB->z - pointA->z) * t_clear);
+    return edge_voxel_cost(&rest, pointB) == INFINITY;
+}
+
+float Map3D::pointCost(State3D *point) {
+    if (point_in_objects(point)) return INFINITY;
+    return point_voxel_cost(point);
+}
+
+// the integral of the cost along the edge, so an edge through free space costs its length
+float Map3D::edgeCost(State3D *pointA, State3D *pointB) {
+    if (edge_in_objects(pointA, pointB)) return INFINITY;
+    return edge_voxel_cost(pointA, pointB);
+}
+
+///////////////////////////////////////  BOUNDING VOLUME HIERARCHY  //////////////////////////////////////
+
+// objects are reordered so every leaf covers a contiguous range of them
+void Map3D::make_bvh() {
+    free(bvh_nodes);
+    free(object_blocks);
+    bvh_nodes = nullptr;
+    object_blocks = nullptr;
+    bvh_node_count = 0;
+    object_block_count = 0;
+    if (object_count == 0) return;
+    // a binary tree with leaves of at least one object has at most 2n-1 nodes, and at most n leaves
+    bvh_nodes = (Map3DBVHNode*)malloc((2 * object_count - 1) * sizeof(Map3DBVHNode));
+    object_blocks = (Map3DObjectBlock*)malloc(object_count * sizeof(Map3DObjectBlock));
+    bvh_node_count = 1;
+    make_bvh_node(0, 0, object_count);
+}
+
+// median split on the longest axis of the object centers
+void Map3D::make_bvh_node(int node, int first, int count) {
+    Map3DBVHNode* current = &bvh_nodes[node];
+    State3D bound_lower = objects[first].bound_lower;
+    State3D bound_upper = objects[first].bound_upper;
+    State3D center_lower, center_upper;
+    for (int i = first; i < first + count; i++) {
+        bound_lower.x = fmin(bound_lower.x, objects[i].bound_lower.x);
+        bound_lower.y = fmin(bound_lower.y, objects[i].bound_lower.y);
+        bound_lower.z = fmin(bound_lower.z, objects[i].bound_lower.z);
+        bound_upper.x = fmax(bound_upper.x, objects[i].bound_upper.x);
+        bound_upper.y = fmax(bound_upper.y, objects[i].bound_upper.y);
+        bound_upper.z = fmax(bound_upper.z, objects[i].bound_upper.z);
+        // doubled centers, to save the divide
+        double cx = objects[i].bound_lower.x + objects[i].bound_upper.x;
+        double cy = objects[i].bound_lower.y + objects[i].bound_upper.y;
+        double cz = objects[i].bound_lower.z + objects[i].bound_upper.z;
+        if (i == first) {
+            center_lower = State3D(cx, cy, cz);
+            center_upper = center_lower;
+        }
+        center_lower.x = fmin(center_lower.x, cx);
+        center_lower.y = fmin(center_lower.y, cy);
+        center_lower.z = fmin(center_lower.z, cz);
+        center_upper.x = fmax(center_upper.x, cx);
+        center_upper.y = fmax(center_upper.y, cy);
+        center_upper.z = fmax(center_upper.z, cz);
+    }
+    // node bounds are rounded outwards to floats, so they still enclose everything below them
+    double lower[3] = {bound_lower.x, bound_lower.y, bound_lower.z};
+    double upper[3] = {bound_upper.x, bound_upper.y, bound_upper.z};
+    for (int axis = 0; axis < 3; axis++) {
+        current->lower[axis] = (float)lower[axis];
+        if (current->lower[axis] > lower[axis]) current->lower[axis] = nextafterf(current->lower[axis], -INFINITY);
+        current->upper[axis] = (float)upper[axis];
+        if (current->upper[axis] < upper[axis]) current->upper[axis] = nextafterf(current->upper[axis], INFINITY);
+    }
+
+    if (count <= MAP3D_BVH_LEAF_SIZE) {
+        Map3DObjectBlock* block = &object_blocks[object_block_count];
+        for (int lane = 0; lane < MAP3D_BVH_LEAF_SIZE; lane++) {
+            Map3DObject* object = &objects[first + (lane < count ? lane : 0)];
+            block->lower[0][lane] = object->bound_lower.x;
+            block->lower[1][lane] = object->bound_lower.y;
+            block->lower[2][lane] = object->bound_lower.z;
+            block->upper[0][lane] = object->bound_upper.x;
+            block->upper[1][lane] = object->bound_upper.y;
+            block->upper[2][lane] = object->bound_upper.z;
+        }
+        current->first = object_block_count++;
+        current->count = count;
+        return;
+    }
+
+    double extent_x = center_upper.x - center_lower.x;
+    double extent_y = center_upper.y - center_lower.y;
+    double extent_z = center_upper.z - center_lower.z;
+    int axis = extent_x >= extent_y && extent_x >= extent_z ? 0 : (extent_y >= extent_z ? 1 : 2);
+    std::nth_element(objects + first, objects + first + count / 2, objects + first + count,
+                     [axis](const Map3DObject& a, const Map3DObject& b) {
+        if (axis == 0) return a.bound_lower.x + a.bound_upper.x < b.bound_lower.x + b.bound_upper.x;
+        if (axis == 1) return a.bound_lower.y + a.bound_upper.y < b.bound_lower.y + b.bound_upper.y;
+        return a.bound_lower.z + a.bound_upper.z < b.bound_lower.z + b.bound_upper.z;
+    });
+
+    int children = bvh_node_count;
+    bvh_node_count += 2;
+    current->first = children;
+    current->count = 0;
+    make_bvh_node(children, first, count / 2);
+    make_bvh_node(children + 1, first + count / 2, count - count / 2);
+}
+
+// true if the point is strictly inside any object
+bool Map3D::point_in_objects(State3D *point) {
+    if (bvh_node_count == 0) return false;
+    double position[3] = {point->x, point->y, point->z};
+    int stack[64];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0) {
+        Map3DBVHNode* node = &bvh_nodes[stack[--stack_size]];
+        if (point->x < node->lower[0] || point->x > node->upper[0]) continue;
+        if (point->y < node->lower[1] || point->y > node->upper[1]) continue;
+        if (point->z < node->lower[2] || point->z > node->upper[2]) continue;
+        if (node->count == 0) {
+            stack[stack_size++] = node->first;
+            stack[stack_size++] = node->first + 1;
+        } else if (point_in_block(position, &object_blocks[node->first])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// true if any point of the segment from pointA to pointB, from t_begin on, is strictly inside an object.
+// the nodes are pruned with closed slab tests, and the leaves are tested exactly.
+bool Map3D::edge_in_objects(State3D *pointA, State3D *pointB, double t_begin) {
+    if (bvh_node_count == 0) return false;
+    double origin[3] = {pointA->x, pointA->y, pointA->z};
+    double direction[3] = {pointB->x - pointA->x, pointB->y - pointA->y, pointB->z - pointA->z};
+    double inverse[3];
+    for (int axis = 0; axis < 3; axis++) {
+        inverse[axis] = direction[axis] == 0 ? 0 : 1 / direction[axis];
+    }
+    int stack[64];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0) {
+        Map3DBVHNode* node = &bvh_nodes[stack[--stack_size]];
+        if (!segment_touches_box(origin, inverse, node->lower, node->upper, t_begin)) continue;
+        if (node->count == 0) {
+            stack[stack_size++] = node->first;
+            stack[stack_size++] = node->first + 1;
+        } else if (segment_hits_block(origin, inverse, &object_blocks[node->first], t_begin)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// closed slab test of origin + t*direction, t in [t_begin, 1], against the box [lower, upper], given the inverse
+// direction (0 on axes the segment doesn't move along).  slightly conservative, since it only prunes nodes.
+bool Map3D::segment_touches_box(double *origin, double *inverse, float *lower, float *upper, double t_begin) {
+    double t_enter = t_begin;
+    double t_exit = 1;
+    for (int axis = 0; axis < 3; axis++) {
+        if (inverse[axis] == 0) {
+            t_exit = origin[axis] < lower[axis] || origin[axis] > upper[axis] ? -1 : t_exit;
+            continue;
+        }
+        double t0 = (lower[axis] - origin[axis]) * inverse[axis];
+        double t1 = (upper[axis] - origin[axis]) * inverse[axis];
+        t_enter = std::max(t_enter, std::min(t0, t1));
+        t_exit = std::min(t_exit, std::max(t0, t1));
+    }
+    return t_enter <= t_exit + 1e-9;
+}
+
+// open slab test against every box of the block: the segment hits a box if some t in [t_begin, 1] is strictly inside
+// it on all three axes, so segments that only graze a face or an edge don't count.
+// the lanes are independent and branch free, so the compiler can run them as vectors.
+bool Map3D::segment_hits_block(double *origin, double *inverse, Map3DObjectBlock *block, double t_begin) {
+    double t_enter[MAP3D_BVH_LEAF_SIZE];
+    double t_exit[MAP3D_BVH_LEAF_SIZE];
+    for (int lane = 0; lane < MAP3D_BVH_LEAF_SIZE; lane++) {
+        t_enter[lane] = t_begin;
+        t_exit[lane] = 1;
+    }
+    for (int axis = 0; axis < 3; axis++) {
+        double* lower = block->lower[axis];
+        double* upper = block->upper[axis];
+        if (inverse[axis] == 0) {
+            for (int lane = 0; lane < MAP3D_BVH_LEAF_SIZE; lane++) {
+                bool inside = lower[lane] < origin[axis] && origin[axis] < upper[lane];
+                t_exit[lane] = inside ? t_exit[lane] : -1;
+            }
+            continue;
+        }
+        for (int lane = 0; lane < MAP3D_BVH_LEAF_SIZE; lane++) {
+            double t0 = (lower[lane] - origin[axis]) * inverse[axis];
+            double t1 = (upper[lane] - origin[axis]) * inverse[axis];
+            t_enter[lane] = std::max(t_enter[lane], std::min(t0, t1));
+            t_exit[lane] = std::min(t_exit[lane], std::max(t0, t1));
+        }
+    }
+    bool hit = false;
+    for (int lane = 0; lane < MAP3D_BVH_LEAF_SIZE; lane++) {
+        hit |= t_enter[lane] < t_exit[lane];
+    }
+    return hit;
+}
+
+bool Map3D::point_in_block(double *point, Map3DObjectBlock *block) {
+    bool hit = false;
+    for (int lane = 0; lane < MAP3D_BVH_LEAF_SIZE; lane++) {
+        bool x_inside = block->lower[0][lane] < point[0] && point[0] < block->upper[0][lane];
+        bool y_inside = block->lower[1][lane] < point[1] && point[1] < block->upper[1][lane];
+        bool z_inside = block->lower[2][lane] < point[2] && point[2] < block->upper[2][lane];
+        hit |= x_inside && y_inside && z_inside;
+    }
+    return hit;
+}
+
+/////////////////////////////////////////////////  VOXELS  ///////////////////////////////////////////////////
+
+// brick coordinates are voxel coordinates shifted down by MAP3D_BRICK_BITS, 21 bits per axis
+uint64_t Map3D::brick_key(int brick_x, int brick_y, int brick_z) {
+    const uint64_t mask = (1 << 21) - 1;
+    return ((uint64_t)(brick_x & mask) << 42) | ((uint64_t)(brick_y & mask) << 21) | (uint64_t)(brick_z & mask);
+}
+
+// bricks are found through an open addressing table of brick indices, -1 where empty, kept at most half full
+Map3DBrick* Map3D::find_brick(int brick_x, int brick_y, int brick_z) {
+    if (brick_table_size == 0) return nullptr;
+    int x = brick_x << MAP3D_BRICK_BITS;
+    int y = brick_y << MAP3D_BRICK_BITS;
+    int z = brick_z << MAP3D_BRICK_BITS;
+    uint32_t mask = brick_table_size - 1;
+    for (uint32_t slot = brick_slot(brick_key(brick_x, brick_y, brick_z)); ; slot = (slot + 1) & mask) {
+        int index = brick_table[slot];
+        if (index < 0) return nullptr;
+        if (bricks[index].x == x && bricks[index].y == y && bricks[index].z == z) return &bricks[index];
+    }
+}
+
+uint32_t Map3D::brick_slot(uint64_t key) {
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & (brick_table_size - 1);
+}
+
+void Map3D::make_brick_table(int size) {
+    free(brick_table);
+    brick_table_size = size;
+    brick_table = (int32_t*)malloc(brick_table_size * sizeof(int32_t));
+    for (int i = 0; i < brick_table_size; i++) {
+        brick_table[i] = -1;
+    }
+    for (int i = 0; i < brick_count; i++) {
+        insert_brick(i);
+    }
+}
+
+void Map3D::insert_brick(int index) {
+    uint64_t key = brick_key(bricks[index].x >> MAP3D_BRICK_BITS, bricks[index].y >> MAP3D_BRICK_BITS, bricks[index].z >> MAP3D_BRICK_BITS);
+    uint32_t slot = brick_slot(key);
+    while (brick_table[slot] >= 0) {
+        slot = (slot + 1) & (brick_table_size - 1);
+    }
+    brick_table[slot] = index;
+}
+
+void Map3D::set_voxel(int x, int y, int z, float cost) {
+    int brick_x = x >> MAP3D_BRICK_BITS;
+    int brick_y = y >> MAP3D_BRICK_BITS;
+    int brick_z = z >> MAP3D_BRICK_BITS;
+    Map3DBrick* brick = find_brick(brick_x, brick_y, brick_z);
+    if (brick == nullptr) {
+        if (brick_count == brick_capacity) {
+            brick_capacity = brick_capacity == 0 ? 64 : brick_capacity * 2;
+            bricks = (Map3DBrick*)realloc(bricks, brick_capacity * sizeof(Map3DBrick));
+        }
+        brick = &bricks[brick_count];
+        brick->x = brick_x << MAP3D_BRICK_BITS;
+        brick->y = brick_y << MAP3D_BRICK_BITS;
+        brick->z = brick_z << MAP3D_BRICK_BITS;
+        for (int i = 0; i < MAP3D_BRICK_VOXELS; i++) {
+            brick->cost[i] = 1;
+        }
+        brick_count++;
+        if (brick_count * 2 > brick_table_size) {
+            make_brick_table(brick_table_size == 0 ? 128 : brick_table_size * 2);
+        } else {
+            insert_brick(brick_count - 1);
+        }
+    }
+    brick->cost[voxel_index(x, y, z)] = cost;
+    minimum_cost = fmin(minimum_cost, cost);
+}
+
+float Map3D::point_voxel_cost(State3D *point) {
+    if (brick_count == 0) return 1;
+    int x = (int)floor(point->x / voxel_size);
+    int y = (int)floor(point->y / voxel_size);
+    int z = (int)floor(point->z / voxel_size);
+    Map3DBrick* brick = find_brick(x >> MAP3D_BRICK_BITS, y >> MAP3D_BRICK_BITS, z >> MAP3D_BRICK_BITS);
+    return brick == nullptr ? 1 : brick->cost[voxel_index(x, y, z)];
+}
+
+// integral of the voxel costs along the segment, or INFINITY as soon as it enters an obstacle voxel.
+// a 3d DDA, which crosses the bricks that aren't stored in one step each.
+float Map3D::edge_voxel_cost(State3D *pointA, State3D *pointB) {
+    if (brick_count == 0) {
+        State3D diff(pointB->x - pointA->x, pointB->y - pointA->y, pointB->z - pointA->z);
+        return sqrtf(diff.x*diff.x + diff.y*diff.y + diff.z*diff.z);
+    }
+    GridTraversal3D cells(pointA->x / voxel_size, pointA->y / voxel_size, pointA->z / voxel_size,
+                          pointB->x / voxel_size, pointB->y / voxel_size, pointB->z / voxel_size);
+    double sum = 0;
+    uint64_t last_key = 0;
+    Map3DBrick* brick = nullptr;
+    bool found = false;
+    while (cells.next()) {
+        int x = cells.getX();
+        int y = cells.getY();
+        int z = cells.getZ();
+        uint64_t key = brick_key(x >> MAP3D_BRICK_BITS, y >> MAP3D_BRICK_BITS, z >> MAP3D_BRICK_BITS);
+        if (!found || key != last_key) {
+            brick = find_brick(x >> MAP3D_BRICK_BITS, y >> MAP3D_BRICK_BITS, z >> MAP3D_BRICK_BITS);
+            last_key = key;
+            found = true;
+        }
+        if (brick == nullptr) {
+            sum += cells.leaveBlock(MAP3D_BRICK_BITS);
+            continue;
+        }
+        float cost = brick->cost[voxel_index(x, y, z)];
+        if (cost == INFINITY) return INFINITY;
+        sum += cost * cells.getLength();
+    }
+    return sum * voxel_size;
+}
+
+//////////////////////////////////////////////  DISTANCE FIELD  //////////////////////////////////////////////
+
+// cells are marked if any obstacle touches them, so the field never overstates the clearance.  the distances are a
+// separable euclidean distance transform, along x, then y, then z.  cell_size 0 picks one that fits the border into
+// about MAP3D_DISTANCE_FIELD_CELLS cells, and no smaller than the voxels.
+void Map3D::makeDistanceField(float cell_size) {
+    const float FAR = 1e20f;
+    double extent[3] = {border.bound_upper.x - border.bound_lower.x, border.bound_upper.y - border.bound_lower.y,
+                        border.bound_upper.z - border.bound_lower.z};
+    if (cell_size <= 0) {
+        cell_size = cbrt(extent[0] * extent[1] * extent[2] / MAP3D_DISTANCE_FIELD_CELLS);
+        if (brick_count > 0) cell_size = max(cell_size, voxel_size);
+        if (!(cell_size > 0)) cell_size = 1;
+    }
+    field_cell_size = cell_size;
+    field_inverse_cell_size = 1.0 / cell_size;
+    field_origin[0] = border.bound_lower.x;
+    field_origin[1] = border.bound_lower.y;
+    field_origin[2] = border.bound_lower.z;
+    for (int axis = 0; axis < 3; axis++) {
+        field_size[axis] = max(1, (int)ceil(extent[axis] / cell_size));
+    }
+    int width = field_size[0];
+    int height = field_size[1];
+    int depth = field_size[2];
+    size_t cells = (size_t)width * height * depth;
+
+    free(distance_field);
+    distance_field = (float*)malloc(cells * sizeof(float));
+    for (size_t i = 0; i < cells; i++) {
+        distance_field[i] = FAR;
+    }
+    field_complete = true;
+    for (int i = 0; i < object_count; i++) {
+        double lower[3] = {objects[i].bound_lower.x, objects[i].bound_lower.y, objects[i].bound_lower.z};
+        double upper[3] = {objects[i].bound_upper.x, objects[i].bound_upper.y, objects[i].bound_upper.z};
+        mark_occupied(lower, upper);
+    }
+    for (int i = 0; i < brick_count; i++) {
+        for (int voxel = 0; voxel < MAP3D_BRICK_VOXELS; voxel++) {
+            if (bricks[i].cost[voxel] != INFINITY) continue;
+            const int mask = (1 << MAP3D_BRICK_BITS) - 1;
+            double lower[3] = {(double)(bricks[i].x + (voxel & mask)) * voxel_size,
+                               (double)(bricks[i].y + ((voxel >> MAP3D_BRICK_BITS) & mask)) * voxel_size,
+                               (double)(bricks[i].z + (voxel >> (2 * MAP3D_BRICK_BITS))) * voxel_size};
+            double upper[3] = {lower[0] + voxel_size, lower[1] + voxel_size, lower[2] + voxel_size};
+            mark_occupied(lower, upper);
+        }
+    }
+
+    transform_field_axis(height * depth, width, 1, [width](int line) { return (size_t)line * width; });
+    transform_field_axis(width * depth, height, width, [width, height](int line) {
+        return (size_t)(line / width) * width * height + line % width;
+    });
+    transform_field_axis(width * height, depth, (size_t)width * height, [](int line) { return (size_t)line; });
+
+    parallel_for(depth, 1, [this, width, height, FAR](int begin, int end) {
+        for (size_t i = (size_t)begin * width * height; i < (size_t)end * width * height; i++) {
+            distance_field[i] = distance_field[i] >= FAR ? INFINITY : sqrtf(distance_field[i]) * field_cell_size;
+        }
+    });
+}
+
+bool Map3D::hasDistanceField() {
+    return distance_field != nullptr;
+}
+
+float Map3D::getDistanceFieldCellSize() {
+    return field_cell_size;
+}
+
+// the distance field at the cell holding the point, 0 outside the field or without one
+float Map3D::getDistance(State3D *point) {
+    size_t cell = field_cell(point->x, point->y, point->z);
+    return cell == SIZE_MAX ? 0 : distance_field[cell];
+}
+
+// a lower bound on the distance from the point to any obstacle, <= 0 if it may be touching one.
+// the point and the obstacle are each within half a cell diagonal of the centers the field measures between.
+float Map3D::getClearance(State3D *point) {
+    size_t cell = field_cell(point->x, point->y, point->z);
+    if (cell == SIZE_MAX) return 0;
+    float clearance = distance_field[cell] - 1.7321f * field_cell_size;
+    if (!field_complete) {
+        for (int axis = 0; axis < 3; axis++) {
+            double position = axis == 0 ? point->x : (axis == 1 ? point->y : point->z);
+            double field_upper = field_origin[axis] + field_size[axis] * (double)field_cell_size;
+            clearance = min(clearance, (float)min(position - field_origin[axis], field_upper - position));
+        }
+    }
+    return clearance;
+}
+
+// index of the cell holding the point, SIZE_MAX outside the field or without one
+size_t Map3D::field_cell(double x, double y, double z) {
+    if (distance_field == nullptr) return SIZE_MAX;
+    double cell_x = (x - field_origin[0]) * field_inverse_cell_size;
+    double cell_y = (y - field_origin[1]) * field_inverse_cell_size;
+    double cell_z = (z - field_origin[2]) * field_inverse_cell_size;
+    if (!(cell_x >= 0 && cell_x < field_size[0])) return SIZE_MAX;
+    if (!(cell_y >= 0 && cell_y < field_size[1])) return SIZE_MAX;
+    if (!(cell_z >= 0 && cell_z < field_size[2])) return SIZE_MAX;
+    return ((size_t)cell_z * field_size[1] + (size_t)cell_y) * field_size[0] + (size_t)cell_x;
+}
+
+// marks the cells the closed box [lower, upper] touches as obstacles, 0 in the field before the transform
+void Map3D::mark_occupied(double *lower, double *upper) {
+    int begin[3], end[3];
+    for (int axis = 0; axis < 3; axis++) {
+        if (!(lower[axis] < upper[axis])) return;
+        double first = (lower[axis] - field_origin[axis]) / field_cell_size;
+        double last = (upper[axis] - field_origin[axis]) / field_cell_size;
+        if (first < 0 || last > field_size[axis]) field_complete = false;
+        first = std::max(0.0, floor(first));
+        last = std::min((double)field_size[axis] - 1, floor(last));
+        if (first > last) return;
+        begin[axis] = (int)first;
+        end[axis] = (int)last;
+    }
+    for (int z = begin[2]; z <= end[2]; z++) {
+        for (int y = begin[1]; y <= end[1]; y++) {
+            float* row = &distance_field[((size_t)z * field_size[1] + y) * field_size[0]];
+            for (int x = begin[0]; x <= end[0]; x++) {
+                row[x] = 0;
+            }
+        }
+    }
+}
+
+// distance_transform_1d along every line of the field parallel to one axis.  a line has n cells, stride apart, from
+// start(line) on.  the lines are independent, so they're split across threads, each with its own scratch space.
+void Map3D::transform_field_axis(int lines, int n, size_t stride, std::function<size_t(int)> start) {
+    parallel_for(lines, 1, [this, n, stride, start](int begin, int end) {
+        float* f = (float*)malloc(n * sizeof(float));
+        float* d = (float*)malloc(n * sizeof(float));
+        int* v = (int*)malloc(n * sizeof(int));
+        float* z = (float*)malloc((n + 1) * sizeof(float));
+        for (int line = begin; line < end; line++) {
+            float* cells = &distance_field[start(line)];
+            for (int i = 0; i < n; i++) {
+                f[i] = cells[i * stride];
+            }
+            distance_transform_1d(f, n, d, v, z);
+            for (int i = 0; i < n; i++) {
+                cells[i * stride] = d[i];
+            }
+        }
+        free(f);
+        free(d);
+        free(v);
+        free(z);
+    });
+}
+
+// sphere tracing: steps along the edge by the clearance at each point, which no obstacle can be closer than.  returns
+// how far along the edge, from 0 to 1, is certainly clear.  it stops where the clearance drops under half a cell, or
+// after MAP3D_TRACE_STEPS steps, since by then the exact tests are cheaper.
+// only voxel maps are traced: a few field lookups, which mostly miss the cache, cost more than the BVH test of a
+// whole edge, but less than walking the voxels.
+double Map3D::trace_edge(State3D *pointA, State3D *pointB) {
+    if (distance_field == nullptr || brick_count == 0) return 0;
+    State3D direction(pointB->x - pointA->x, pointB->y - pointA->y, pointB->z - pointA->z);
+    double length = sqrt(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+    double inverse_length = length > 0 ? 1 / length : 0;
+    float margin = 1.7321f * field_cell_size;
+    float minimum_step = 0.5f * field_cell_size;
+    double travelled = 0;
+    for (int step = 0; step < MAP3D_TRACE_STEPS; step++) {
+        double t = travelled * inverse_length;
+        double x = pointA->x + direction.x * t;
+        double y = pointA->y + direction.y * t;
+        double z = pointA->z + direction.z * t;
+        size_t cell = field_cell(x, y, z);
+        if (cell == SIZE_MAX) break;
+        float clearance = distance_field[cell] - margin;
+        if (!field_complete) {
+            State3D point(x, y, z);
+            clearance = getClearance(&point);
+        }
+        if (clearance < minimum_step) break;
+        travelled += clearance;
+        if (travelled >= length) return 1;
+    }
+    return travelled * inverse_length;
+}
+
+//////////////////////////////////////////////  MAP3D FILES  /////////////////////////////////////////////////
+
+// the objects, BVH and voxels, ready to map straight back into memory
+void Map3D::saveMap3D(std::string filename) {
+    FILE* fp = fopen(filename.c_str(), "wb");
+    if (!fp) abort();
+
+    Map3DFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAP3D_FILE_MAGIC, sizeof(header.magic));
+    header.version = MAP3D_FILE_VERSION;
+    header.object_count = object_count;
+    header.bvh_node_count = bvh_node_count;
+    header.object_block_count = object_block_count;
+    header.brick_count = brick_count;
+    header.brick_table_size = brick_table_size;
+    header.voxel_size = voxel_size;
+    header.minimum_cost = minimum_cost;
+    header.border[0] = border.bound_lower.x;
+    header.border[1] = border.bound_lower.y;
+    header.border[2] = border.bound_lower.z;
+    header.border[3] = border.bound_upper.x;
+    header.border[4] = border.bound_upper.y;
+    header.border[5] = border.bound_upper.z;
+    header.content_hash = getContentHash();
+
+    std::vector<std::pair<const void*, size_t>> arrays;
+    arrays.push_back(std::make_pair((const void*)objects, object_count * sizeof(Map3DObject)));
+    arrays.push_back(std::make_pair((const void*)bvh_nodes, bvh_node_count * sizeof(Map3DBVHNode)));
+    arrays.push_back(std::make_pair((const void*)object_blocks, object_block_count * sizeof(Map3DObjectBlock)));
+    arrays.push_back(std::make_pair((const void*)bricks, brick_count * sizeof(Map3DBrick)));
+    arrays.push_back(std::make_pair((const void*)brick_table, brick_table_size * sizeof(int32_t)));
+
+    static const char padding[FILE_ALIGNMENT] = {0};
+    size_t offset = fwrite(&header, 1, sizeof(header), fp);
+    for (std::pair<const void*, size_t>& array : arrays) {
+        offset += fwrite(padding, 1, align_offset(offset) - offset, fp);
+        if (array.second > 0) {
+            offset += fwrite(array.first, 1, array.second, fp);
+        }
+    }
+    if (offset != align_offset(offset)) {
+        offset += fwrite(padding, 1, align_offset(offset) - offset, fp);
+    }
+
+    fclose(fp);
+}
+
+// the arrays are used in place, from a read only private mapping of the file, so loading costs the same for any scene
+// size and processes planning on the same scene share its pages
+void Map3D::load_map3d(std::string filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) abort();
+    struct stat sb;
+    if (fstat(fd, &sb) != 0) abort();
+    mapped_size = sb.st_size;
+    mapped_file = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped_file == MAP_FAILED) abort();
+
+    if (mapped_size < sizeof(Map3DFileHeader)) abort();
+    Map3DFileHeader* header = (Map3DFileHeader*)mapped_file;
+    if (memcmp(header->magic, MAP3D_FILE_MAGIC, sizeof(header->magic)) != 0) abort();
+    if (header->version != MAP3D_FILE_VERSION) abort();
+
+    object_count = header->object_count;
+    bvh_node_count = header->bvh_node_count;
+    object_block_count = header->object_block_count;
+    brick_count = header->brick_count;
+    brick_table_size = header->brick_table_size;
+    voxel_size = header->voxel_size;
+    minimum_cost = header->minimum_cost;
+    border.bound_lower = State3D(header->border[0], header->border[1], header->border[2]);
+    border.bound_upper = State3D(header->border[3], header->border[4], header->border[5]);
+    content_hash = header->content_hash;
+
+    uint8_t* base = (uint8_t*)mapped_file;
+    size_t offset = align_offset(sizeof(Map3DFileHeader));
+    objects = (Map3DObject*)(base + offset);
+    offset = align_offset(offset + object_count * sizeof(Map3DObject));
+    bvh_nodes = (Map3DBVHNode*)(base + offset);
+    offset = align_offset(offset + bvh_node_count * sizeof(Map3DBVHNode));
+    object_blocks = (Map3DObjectBlock*)(base + offset);
+    offset = align_offset(offset + object_block_count * sizeof(Map3DObjectBlock));
+    bricks = (Map3DBrick*)(base + offset);
+    offset = align_offset(offset + brick_count * sizeof(Map3DBrick));
+    brick_table = (int32_t*)(base + offset);
+    offset = align_offset(offset + brick_table_size * sizeof(int32_t));
+    if (offset > mapped_size) abort();
+}
+
+uint64_t Map3D::getContentHash() {
+    if (content_hash == 0) {
+        content_hash = compute_content_hash();
+    }
+    return content_hash;
+}
+
+// true if the map still hashes to the content hash, e.g. the one a .map3d file was saved with
+bool Map3D::verifyContentHash() {
+    return compute_content_hash() == getContentHash();
+}
+
+uint64_t Map3D::compute_content_hash() {
+    double bounds[6] = {border.bound_lower.x, border.bound_lower.y, border.bound_lower.z,
+                        border.bound_upper.x, border.bound_upper.y, border.bound_upper.z};
+    uint64_t hash = fnv1a_64(bounds, sizeof(bounds));
+    hash = fnv1a_64(&voxel_size, sizeof(voxel_size), hash);
+    hash = fnv1a_64(objects, object_count * sizeof(Map3DObject), hash);
+    return fnv1a_64(bricks, brick_count * sizeof(Map3DBrick), hash);
 }
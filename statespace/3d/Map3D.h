@@ -3,9 +3,24 @@
 
 #include "State3D.h"
 #include <string>
+#include <cstdio>
+#include <cstdint>
+#include <functional>
 #include <png.h>
 
-#define MAP3D_MAX_OBJECTS 1000
+#define MAP3D_BVH_LEAF_SIZE 4
+
+#define MAP3D_BRICK_BITS 3
+#define MAP3D_BRICK_VOXELS (1 << (3 * MAP3D_BRICK_BITS))
+
+// the automatic distance field cell size fits the border into about this many cells
+#define MAP3D_DISTANCE_FIELD_CELLS (1 << 18)
+// edges give up on the distance field after this many steps and test the rest of the way exactly
+#define MAP3D_TRACE_STEPS 16
+
+// maps saved by saveMap3D() are loaded from files with this extension, anything else is parsed as text
+const std::string MAP3D_FILE_EXTENSION = ".map3d";
+const uint32_t MAP3D_FILE_VERSION = 1;
 
 class Map3DObject {
 public:
@@ -13,20 +28,60 @@ public:
     State3D bound_upper;
 };
 
+// the boxes of one BVH leaf, laid out by axis so the intersection tests run across all of them at once.
+// leaves with fewer boxes repeat their first box in the unused lanes.
+class Map3DObjectBlock {
+public:
+    double lower[3][MAP3D_BVH_LEAF_SIZE];
+    double upper[3][MAP3D_BVH_LEAF_SIZE];
+};
+
+// node of the bounding volume hierarchy over the map objects.  leaves (count > 0) hold count boxes in
+// object_blocks[first], inner nodes (count == 0) have their two children at bvh_nodes[first] and bvh_nodes[first+1].
+class Map3DBVHNode {
+public:
+    float lower[3];
+    float upper[3];
+    int first;
+    int count;
+};
+
+// an 8x8x8 block of voxel costs, at voxel (x, y, z).  only the blocks holding at least one voxel from the map file are
+// stored, the rest of space costs 1 per unit length.
+class Map3DBrick {
+public:
+    int x, y, z;
+    float cost[MAP3D_BRICK_VOXELS];
+};
+
 class Map3D {
 
 friend class State3DMath;
 
 public:
     Map3D(std::string datafile);
+    ~Map3D();
+    void saveMap3D(std::string filename);
+    uint64_t getContentHash();
+    bool verifyContentHash();
 
     void getBounds(State3D* minimums, State3D* maximums);
+    int getObjectCount();
+    int getBrickCount();
+    float getVoxelSize();
+    float getMinimumCost();
 
     bool pointInObstacle(State3D* point);
     bool edgeInObstacle(State3D* pointA, State3D* pointB);
     float pointCost(State3D* point);
     float edgeCost(State3D* pointA, State3D* pointB);
 
+    void makeDistanceField(float cell_size=0);
+    bool hasDistanceField();
+    float getDistanceFieldCellSize();
+    float getDistance(State3D* point);
+    float getClearance(State3D* point);
+
     void configureVis(int width, int height);
     void resetVis();
     void addVisPoint(State3D* point, int color, bool big=false);
@@ -38,13 +93,73 @@ public:
     void addDebugText(std::string text);
 
 protected:
+    void load_boxes(FILE* fp);
+    void load_voxels(FILE* fp);
+    void load_map3d(std::string filename);
+    uint64_t compute_content_hash();
+    void add_object(Map3DObject* object);
+    void make_bvh();
+    void make_bvh_node(int node, int first, int count);
+    static bool segment_touches_box(double* origin, double* inverse, float* lower, float* upper, double t_begin);
+    static bool segment_hits_block(double* origin, double* inverse, Map3DObjectBlock* block, double t_begin);
+    static bool point_in_block(double* point, Map3DObjectBlock* block);
+    bool point_in_objects(State3D* point);
+    bool edge_in_objects(State3D* pointA, State3D* pointB, double t_begin=0);
+
+    static uint64_t brick_key(int brick_x, int brick_y, int brick_z);
+    static inline int voxel_index(int x, int y, int z) {
+        const int mask = (1 << MAP3D_BRICK_BITS) - 1;
+        return (((z & mask) << MAP3D_BRICK_BITS | (y & mask)) << MAP3D_BRICK_BITS) | (x & mask);
+    }
+    uint32_t brick_slot(uint64_t key);
+    Map3DBrick* find_brick(int brick_x, int brick_y, int brick_z);
+    void make_brick_table(int size);
+    void insert_brick(int index);
+    void set_voxel(int x, int y, int z, float cost);
+    float point_voxel_cost(State3D* point);
+    float edge_voxel_cost(State3D* pointA, State3D* pointB);
+
+    void mark_occupied(double* lower, double* upper);
+    void transform_field_axis(int lines, int n, size_t stride, std::function<size_t(int)> start);
+    size_t field_cell(double x, double y, double z);
+    double trace_edge(State3D* pointA, State3D* pointB);
+
     void write_video(std::string filename_prefix);
     std::string ReplaceString(std::string subject, const std::string& search, const std::string& replace);
     void add_image_to_list(std::string filename_prefix);
 
     Map3DObject border;
-    Map3DObject objects[MAP3D_MAX_OBJECTS];
+    Map3DObject* objects = nullptr;
     int object_count = 0;
+    int object_capacity = 0;
+
+    Map3DBVHNode* bvh_nodes = nullptr;
+    int bvh_node_count = 0;
+    Map3DObjectBlock* object_blocks = nullptr;
+    int object_block_count = 0;
+
+    float voxel_size = 1;
+    Map3DBrick* bricks = nullptr;
+    int brick_count = 0;
+    int brick_capacity = 0;
+    int32_t* brick_table = nullptr;
+    int brick_table_size = 0;
+
+    // set when the arrays above point into a memory mapped .map3d file rather than their own allocations
+    void* mapped_file = nullptr;
+    size_t mapped_size = 0;
+    uint64_t content_hash = 0;
+    float minimum_cost = 1;
+
+    // distance from each cell to the nearest cell an obstacle touches, between cell centers, INFINITY if there are no
+    // obstacles.  cell (x, y, z) is at field[(z * field_size[1] + y) * field_size[0] + x].  field_complete is false if
+    // some obstacle reaches outside the field, and so isn't all in it.
+    float* distance_field = nullptr;
+    int field_size[3] = {0, 0, 0};
+    double field_origin[3] = {0, 0, 0};
+    float field_cell_size = 0;
+    double field_inverse_cell_size = 0;
+    bool field_complete = true;
 
     std::string html = "";
 
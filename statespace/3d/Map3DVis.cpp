@@ -69,6 +69,18 @@ void Map3D::renderVis(std::string filename_prefix) {
         html += "obstacles.push({origin:[" + std::to_string(objects[i].bound_lower.x) + ", " + std::to_string(objects[i].bound_lower.y) + ", " + std::to_string(objects[i].bound_lower.z) + "], size:[" + std::to_string(dx) + "," + std::to_string(dy) + "," + std::to_string(dz) + "]});\n";
     }
 
+    // obstacle voxels
+    std::string voxel_size_string = std::to_string(voxel_size);
+    for (int i=0; i<brick_count; i++) {
+        for (int v=0; v<MAP3D_BRICK_VOXELS; v++) {
+            if (bricks[i].cost[v] != INFINITY) continue;
+            float x = (bricks[i].x + (v & ((1 << MAP3D_BRICK_BITS) - 1))) * voxel_size;
+            float y = (bricks[i].y + ((v >> MAP3D_BRICK_BITS) & ((1 << MAP3D_BRICK_BITS) - 1))) * voxel_size;
+            float z = (bricks[i].z + (v >> (2 * MAP3D_BRICK_BITS))) * voxel_size;
+            html += "obstacles.push({origin:[" + std::to_string(x) + ", " + std::to_string(y) + ", " + std::to_string(z) + "], size:[" + voxel_size_string + "," + voxel_size_string + "," + voxel_size_string + "]});\n";
+        }
+    }
+
     // map border
     float dx = border.bound_upper.x - border.bound_lower.x;
     float dy = border.bound_upper.y - border.bound_lower.y;
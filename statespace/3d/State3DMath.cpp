@@ -1,5 +1,7 @@
 #include "State3DMath.h"
 #include <cmath>
+#include <cstdlib>
+#include "utils.h"
 
 ///////////////////////////////////////////////  SETUP  //////////////////////////////////////////////////
 
@@ -16,61 +18,103 @@ void State3DMath::setMap(Map3D *_map) {
     State3D _minimums, _maximums;
     map->getBounds(&_minimums, &_maximums);
     setRandomStateConstraints(_minimums, _maximums);
+    load_distance_field();
 }
 
 void State3DMath::setCostScale(float _scale) {
     cost_scale = _scale;
 }
 
+// edges closer than margin to an obstacle cost an extra weight * (margin - distance) per unit length, which keeps
+// paths away from the obstacles.  weight 0, the default, turns it off.
+void State3DMath::setClearanceCost(float weight, float margin) {
+    clearance_weight = weight;
+    clearance_margin = margin;
+    load_distance_field();
+}
+
+// only voxel cost edges and the clearance penalty read the distance field, box maps check edges exactly without it
+void State3DMath::load_distance_field() {
+    if (map == nullptr || map->hasDistanceField()) return;
+    if (map->getBrickCount() > 0 || clearance_weight > 0) {
+        map->makeDistanceField();
+    }
+}
+
 ////////////////////////////////////////  OBSTACLE DETECTION  ////////////////////////////////////////////
 
 bool State3DMath::pointInObstacle(State3D *point) {
-    for (int i=0; i<map->object_count; i++) {
-        bool x_inside = point->x > map->objects[i].bound_lower.x && point->x < map->objects[i].bound_upper.x;
-        bool y_inside = point->y > map->objects[i].bound_lower.y && point->y < map->objects[i].bound_upper.y;
-        bool z_inside = point->z > map->objects[i].bound_lower.z && point->z < map->objects[i].bound_upper.z;
-        if (x_inside && y_inside && z_inside) {
-            return true;
-        }
-    }
-    return false;
+    return map->pointInObstacle(point);
 }
 
 bool State3DMath::edgeInObstacle(State3D *pointA, State3D *pointB) {
-    State3D diff(pointB->x - pointA->x, pointB->y - pointA->y, pointB->z - pointA->z);
-    float step = EDGE_WALK_SCALE / sqrtf(diff.x*diff.x + diff.y*diff.y + diff.z*diff.z);
-    for (float progress = 0; progress < 1; progress += step) {
-        State3D point(pointA->x + diff.x * progress, pointA->y + diff.y * progress, pointA->z + diff.z * progress);
-        if (pointInObstacle(&point)) {
-            return true;
-        }
-    }
-    return false;
+    return map->edgeInObstacle(pointA, pointB);
 }
 
 /////////////////////////////////////////  COST CALCULATIONS  ////////////////////////////////////////////
 
+bool State3DMath::point_outside_border(State3D *point) {
+    if (point->x < map->border.bound_lower.x || point->x > map->border.bound_upper.x) return true;
+    if (point->y < map->border.bound_lower.y || point->y > map->border.bound_upper.y) return true;
+    if (point->z < map->border.bound_lower.z || point->z > map->border.bound_upper.z) return true;
+    return false;
+}
+
+// the border is a box, so a segment stays inside it exactly when both of its ends do
+bool State3DMath::edge_outside_border(State3D *pointA, State3D *pointB) {
+    return point_outside_border(pointA) || point_outside_border(pointB);
+}
+
 float State3DMath::pointCost(State3D *point) {
-    if (point->x < map->border.bound_lower.x || point->x > map->border.bound_upper.x) return INFINITY;
-    if (point->y < map->border.bound_lower.y || point->x > map->border.bound_upper.y) return INFINITY;
-    if (point->z < map->border.bound_lower.z || point->x > map->border.bound_upper.z) return INFINITY;
-    return pointInObstacle(point) ? INFINITY : 1;
+    if (point_outside_border(point)) return INFINITY;
+    return map->pointCost(point);
 }
 
 float State3DMath::edgeCost(State3D *pointA, State3D *pointB, State3D *pointB_updated) {
-    float sum = 0;
-    State3D diff(pointB->x - pointA->x, pointB->y - pointA->y, pointB->z - pointA->z);
-    int iterations = 0;
-    float length = sqrtf(diff.x*diff.x + diff.y*diff.y + diff.z*diff.z);
-    for (float progress = 0; progress < 1; progress += EDGE_WALK_SCALE / length) {
-        State3D point(pointA->x + diff.x * progress, pointA->y + diff.y * progress, pointA->z + diff.z * progress);
-        sum += pointCost(&point);
-        iterations++;
-    }
     if (pointB_updated != nullptr) {
         *pointB_updated = *pointB;
     }
-    return iterations == 0 ? 0 : sum / iterations * length;
+    if (edge_outside_border(pointA, pointB)) return INFINITY;
+    float cost = map->edgeCost(pointA, pointB);
+    if (clearance_weight > 0 && cost != INFINITY) {
+        cost += clearance_penalty(pointA, pointB);
+    }
+    return cost;
+}
+
+// the clearance cost integrated along the edge, sampled once per distance field cell.  the field at a point is within
+// a cell diagonal of the field at pointA plus the distance between them, so edges that stay far enough from
+// everything skip the sampling.
+float State3DMath::clearance_penalty(State3D *pointA, State3D *pointB) {
+    float cell_size = map->getDistanceFieldCellSize();
+    double length = distance(pointA, pointB);
+    if (map->getDistance(pointA) - length - 1.7321f * cell_size >= clearance_margin) return 0;
+    int samples = max(1, (int)ceil(length / cell_size));
+    double sum = 0;
+    for (int i = 0; i < samples; i++) {
+        double t = (i + 0.5) / samples;
+        State3D point(pointA->x + (pointB->x - pointA->x) * t, pointA->y + (pointB->y - pointA->y) * t,
+                      pointA->z + (pointB->z - pointA->z) * t);
+        sum += max(0.0f, clearance_margin - map->getDistance(&point));
+    }
+    return clearance_weight * sum * length / samples;
+}
+
+// edgeInObstacle and edgeCost with one walk, since the map's edge cost is infinite exactly when the edge collides
+EdgeEvaluation<State3D> State3DMath::evaluateEdge(State3D *source, State3D *dest) {
+    EdgeEvaluation<State3D> result;
+    result.dest = *dest;
+    if (edge_outside_border(source, dest)) {
+        result.collides = map->edgeInObstacle(source, dest);
+        result.cost = INFINITY;
+        return result;
+    }
+    result.cost = map->edgeCost(source, dest);
+    result.collides = result.cost == INFINITY;
+    if (clearance_weight > 0 && !result.collides) {
+        result.cost += clearance_penalty(source, dest);
+    }
+    return result;
 }
 
 ///////////////////////////////////////  DISTANCE CALCULATIONS  //////////////////////////////////////////
@@ -87,6 +131,13 @@ double State3DMath::approx_distance(State3D* a, State3D* b) {
     return fabs(a->x - b->x) + fabs(a->y - b->y) + fabs(a->z - b->z);
 }
 
+// admissible estimate of the cost from source to dest.  no point costs less than the map's minimum cost, so the
+// straight line distance at that cost is a lower bound; it's shaved slightly so float rounding in edgeCost() can't
+// push it past the real cost.
+float State3DMath::costToGo(State3D* source, State3D* dest) {
+    return 0.999f * map->getMinimumCost() * distance(source, dest);
+}
+
 ////////////////////////////////////////// SAMPLE GENERATION /////////////////////////////////////////////
 
 void State3DMath::setRandomStateConstraints(State3D _minimums, State3D _maximums) {
@@ -101,10 +152,14 @@ void State3DMath::setRandomStateConstraints(State3D _minimums, State3D _maximums
     shift.z = minimums.z;
 }
 
+void State3DMath::setRandomSeed(unsigned int seed) {
+    random_seed = seed;
+}
+
 State3D State3DMath::getRandomState() {
     State3D output;
-    output.x = (double)rand() * scale.x + shift.x;
-    output.y = (double)rand() * scale.y + shift.y;
-    output.z = (double)rand() * scale.z + shift.z;
+    output.x = (double)rand_r(&random_seed) * scale.x + shift.x;
+    output.y = (double)rand_r(&random_seed) * scale.y + shift.y;
+    output.z = (double)rand_r(&random_seed) * scale.z + shift.z;
     return output;
 }
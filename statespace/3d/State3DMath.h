@@ -3,6 +3,7 @@
 
 #include "State3D.h"
 #include "Map3D.h"
+#include "EdgeEvaluation.h"
 
 class State3DMath {
   
@@ -12,26 +13,36 @@ public:
 
     void setMap(Map3D* _map);
     void setCostScale(float _scale);
+    void setClearanceCost(float weight, float margin);
 
     bool pointInObstacle(State3D* point);
     bool edgeInObstacle(State3D* pointA, State3D* pointB);
 
     float pointCost(State3D* point);
     float edgeCost(State3D* pointA, State3D* pointB, State3D* pointB_updated=nullptr);
+    EdgeEvaluation<State3D> evaluateEdge(State3D* source, State3D* dest);
 
     double distance(State3D* a, State3D* b);
     double approx_distance(State3D* a, State3D* b);
+    float costToGo(State3D* source, State3D* dest);
 
     void setRandomStateConstraints(State3D _minimums, State3D _maximums);
+    void setRandomSeed(unsigned int seed);
     State3D getRandomState();
 
 protected:
+    void load_distance_field();
+    bool point_outside_border(State3D* point);
+    bool edge_outside_border(State3D* pointA, State3D* pointB);
+    float clearance_penalty(State3D* pointA, State3D* pointB);
+
     State3D minimums, maximums;
     State3D scale, shift;
+    unsigned int random_seed = 1;
 
     float cost_scale = 1;
-
-    const float EDGE_WALK_SCALE = 1.0f;
+    float clearance_weight = 0;
+    float clearance_margin = 0;
 
     Map3D* map = nullptr;
 };
@@ -6,6 +6,7 @@ MapFloater::MapFloater(std::string pngfile, float _accel_scale) {
     accel_scale = _accel_scale;
     load_png(pngfile);
     make_grayscale();
+    make_occupancy();
     resetVis();
 }
 
@@ -91,6 +92,15 @@ void MapFloater::make_grayscale() {
     }
 }
 
+void MapFloater::make_occupancy() {
+    occupancy = new OccupancyBitmap(image_width, image_height);
+    for (int height_pos = 0; height_pos < image_height; height_pos++) {
+        for (int width_pos = 0; width_pos < image_width; width_pos++) {
+            occupancy->set(width_pos, height_pos, grayscale[grayoffset(width_pos, height_pos)] < MAPFLOATER_OBSTACLE_THRESHOLD);
+        }
+    }
+}
+
 void MapFloater::getBounds(StateFloater *minimums, StateFloater *maximums) {
     minimums->set(0, 0, -INFINITY);
     maximums->set(image_width, image_height, INFINITY);
@@ -102,3 +112,8 @@ float MapFloater::getGrayscalePixel(int width_pos, int height_pos) {
     if (height_pos < 0 || height_pos >= image_height) return out_of_bounds_ok;
     return grayscale[grayoffset(width_pos, height_pos)];
 }
+
+// out of bounds pixels are obstacles
+bool MapFloater::getPixelIsObstacle(int width_pos, int height_pos) {
+    return occupancy->get(width_pos, height_pos);
+}
@@ -3,11 +3,15 @@
 
 #include "StateFloaterMath.h"
 #include "StateFloater.h"
+#include "OccupancyBitmap.h"
 #include <string>
 #include <png.h>
 
 class StateFloaterMath;
 
+// pixels darker than this are obstacles
+const float MAPFLOATER_OBSTACLE_THRESHOLD = 0.01f;
+
 class MapFloater {
 
 public:
@@ -23,6 +27,7 @@ public:
     void renderVis(std::string filename_prefix);
     void renderFinalVis(std::string filename_prefix);
     float getGrayscalePixel(int width_pos, int height_pos);
+    bool getPixelIsObstacle(int width_pos, int height_pos);
     void addDebugText(std::string text);
 
 private:
@@ -31,6 +36,7 @@ private:
     void add_image_to_list(std::string filename_prefix);
     void write_video(std::string filename_prefix);
     void make_grayscale();
+    void make_occupancy();
     inline int grayoffset(int width_pos, int height_pos) { return height_pos * image_width + width_pos; }
     void add_state_display(StateFloater state);
 
@@ -43,6 +49,7 @@ private:
     png_bytep *vis_rows = NULL;
 
     float* grayscale = nullptr;
+    OccupancyBitmap* occupancy = nullptr;
     std::string filelist = "";
 
     float accel_scale = 1;
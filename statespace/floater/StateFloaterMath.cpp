@@ -1,5 +1,6 @@
 #include "StateFloaterMath.h"
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
 
 ///////////////////////////////////////////////  SETUP  //////////////////////////////////////////////////
@@ -22,8 +23,7 @@ void StateFloaterMath::setMap(MapFloater *_map) {
 ////////////////////////////////////////  OBSTACLE DETECTION  ////////////////////////////////////////////
 
 bool StateFloaterMath::pointInObstacle(StateFloater *point) {
-    float grayscale = map->getGrayscalePixel(point->t, point->y);
-    return grayscale < 0.01;
+    return map->getPixelIsObstacle(point->t, point->y);
 }
 
 bool StateFloaterMath::edgeInObstacle(StateFloater *source, StateFloater *dest) {
@@ -91,6 +91,16 @@ float StateFloaterMath::edgeCost(StateFloater *source, StateFloater *dest, State
     return ai;
 }
 
+// costing the edge only takes one solve of the motion problem, while checking it for collisions simulates the whole
+// trajectory.  so the cost goes first, and edges with no trajectory are never simulated.
+EdgeEvaluation<StateFloater> StateFloaterMath::evaluateEdge(StateFloater *source, StateFloater *dest) {
+    EdgeEvaluation<StateFloater> result;
+    result.cost = edgeCost(source, dest, &result.dest);
+    result.collides = result.cost == INFINITY || edgeInObstacle(source, dest);
+    if (result.collides) result.cost = INFINITY;
+    return result;
+}
+
 void StateFloaterMath::edgePath(StateFloater *source, StateFloater *dest, float t[], float p[], float a[], float pointCount) {
     Motion1DPositionVelocityAccelSingleTimed motion;
     configureMotionPlanner(&motion, source, dest);
@@ -132,6 +142,11 @@ double StateFloaterMath::approx_distance(StateFloater *a, StateFloater *b) {
     return 0; // TODO Fix?
 }
 
+// admissible estimate of the cost from source to dest.  coasting is free, so nothing better than 0 is guaranteed.
+float StateFloaterMath::costToGo(StateFloater*, StateFloater*) {
+    return 0;
+}
+
 ////////////////////////////////////////// SAMPLE GENERATION /////////////////////////////////////////////
 
 void StateFloaterMath::setRandomStateConstraints(StateFloater _minimums, StateFloater _maximums) {
@@ -146,10 +161,14 @@ void StateFloaterMath::setRandomStateConstraints(StateFloater _minimums, StateFl
     shift.vy = minimums.vy;
 }
 
+void StateFloaterMath::setRandomSeed(unsigned int seed) {
+    random_seed = seed;
+}
+
 StateFloater StateFloaterMath::getRandomState() {
     StateFloater output;
-    output.t = (double)rand() * scale.t + shift.t;
-    output.y = (double)rand() * scale.y + shift.y;
-    output.vy = (double)rand() * scale.vy + shift.vy;
+    output.t = (double)rand_r(&random_seed) * scale.t + shift.t;
+    output.y = (double)rand_r(&random_seed) * scale.y + shift.y;
+    output.vy = (double)rand_r(&random_seed) * scale.vy + shift.vy;
     return output;
 }
@@ -3,6 +3,7 @@
 
 #include "StateFloater.h"
 #include "MapFloater.h"
+#include "EdgeEvaluation.h"
 #include <motion/Motion1DPositionVelocityAccelSingleTimed.h>
 
 // "Floater" is a sample system, with a hypothetical vehicle that moves forward
@@ -26,13 +27,16 @@ public:
     bool edgeInObstacle(StateFloater* source, StateFloater* dest);
 
     float edgeCost(StateFloater* source, StateFloater* dest, StateFloater* dest_updated=nullptr);
+    EdgeEvaluation<StateFloater> evaluateEdge(StateFloater* source, StateFloater* dest);
 
     void edgePath(StateFloater *source, StateFloater *dest, float t[], float p[], float a[], float pointCount);
 
     double distance(StateFloater* source, StateFloater* dest);
     double approx_distance(StateFloater* a, StateFloater* b);
+    float costToGo(StateFloater* source, StateFloater* dest);
 
     void setRandomStateConstraints(StateFloater _minimums, StateFloater _maximums);
+    void setRandomSeed(unsigned int seed);
     StateFloater getRandomState();
 
 protected:
@@ -40,6 +44,7 @@ protected:
 
     StateFloater minimums, maximums;
     StateFloater scale, shift;
+    unsigned int random_seed = 1;
 
     const float EDGE_WALK_SCALE = 1.0f;
 
@@ -10,6 +10,7 @@ MapRacer::MapRacer(std::string pngfile, float _output_scale, float _output_crop_
     output_crop_y_max = _output_crop_y_max;
     load_png(pngfile);
     make_grayscale();
+    make_occupancy();
     resetVis();
 }
 
@@ -104,6 +105,16 @@ void MapRacer::make_grayscale() {
     }
 }
 
+void MapRacer::make_occupancy() {
+    // coordinate system is +x right, +y up
+    occupancy = new OccupancyBitmap(image_width, image_height);
+    for (int height_pos = 0; height_pos < image_height; height_pos++) {
+        for (int width_pos = 0; width_pos < image_width; width_pos++) {
+            occupancy->set(width_pos, height_pos, grayscale[grayoffset(width_pos, image_height - height_pos - 1)] < MAPRACER_OBSTACLE_THRESHOLD);
+        }
+    }
+}
+
 void MapRacer::getBounds(StateRacer *minimums, StateRacer *maximums) {
     minimums->x = 0;
     minimums->y = 0;
@@ -113,7 +124,7 @@ void MapRacer::getBounds(StateRacer *minimums, StateRacer *maximums) {
     // this does not provide heading limits, since they are fixed at [0, 360]
 }
 
+// out of bounds pixels are obstacles
 bool MapRacer::getPixelIsObstacle(int width_pos, int height_pos) {
-    // coordinate system is +x right, +y up
-    return grayscale[grayoffset(width_pos, image_height - height_pos - 1)] < 0.5f;
+    return occupancy->get(width_pos, height_pos);
 }
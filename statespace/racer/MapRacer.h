@@ -3,11 +3,15 @@
 
 #include "StateRacerMath.h"
 #include "StateRacer.h"
+#include "OccupancyBitmap.h"
 #include <string>
 #include <png.h>
 
 class StateRacerMath;
 
+// pixels darker than this are obstacles
+const float MAPRACER_OBSTACLE_THRESHOLD = 0.5f;
+
 class MapRacer {
 
 public:
@@ -28,6 +32,7 @@ public:
 private:
     void load_png(std::string pngfile);
     void make_grayscale();
+    void make_occupancy();
 
     void write_png(std::string pngfile);
     void add_image_to_list(std::string filename_prefix);
@@ -54,6 +59,8 @@ private:
     png_bytep *vis_rows = NULL;
 
     float* grayscale = nullptr;
+    // stored with +y up, matching the state coordinates
+    OccupancyBitmap* occupancy = nullptr;
     std::string filelist = "";
 
 };
@@ -7,8 +7,24 @@
 
 #include "StateRacer.h"
 
+#define MODELRACER_LANES 8
+
+// the state and controls of MODELRACER_LANES separate runs of the model, laid out by field for ModelRacer::runLanes()
+class ModelRacerLanes {
+public:
+    double x[MODELRACER_LANES];
+    double y[MODELRACER_LANES];
+    double v[MODELRACER_LANES];
+    double h[MODELRACER_LANES];
+    float gas[MODELRACER_LANES];
+    float brake[MODELRACER_LANES];
+    float steering[MODELRACER_LANES];
+};
+
 class ModelRacer {
 
+friend class StateRacerMath;
+
 public:
     ModelRacer(float _gas_strength, float _brake_strength, float _steering_strength, float _steering_friction, float _air_strength, float _dt_internal);
     void reset();
@@ -16,6 +32,7 @@ public:
     void setInitialState(StateRacer* _state);
     void setControls(float _gas, float _brake, float _steering);
     void run(float dt);
+    void runLanes(ModelRacerLanes* lanes, float dt);
     void getState(StateRacer* _state);
 
 private:
@@ -9,6 +9,9 @@ struct ModelRacerEdgeCost {
     float dt;
     float vf;
     float hf;
+    // the LUT path swept on the way, and how many of its points this edge goes through
+    int path;
+    int path_points;
 };
 
 #endif
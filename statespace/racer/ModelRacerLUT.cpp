@@ -0,0 +1,369 @@
+#include "ModelRacerLUT.h"
+#include "utils.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// the arrays follow the header in this order, each starting on a FILE_ALIGNMENT boundary: gases, brakes, steerings,
+// times, slices, the block table, the blocks, the paths and their points.  key identifies the settings the table was
+// made from.
+struct ModelRacerLUTFileHeader {
+    char magic[8];
+    uint32_t version;
+    int32_t v_res;
+    int32_t x_res;
+    int32_t y_res;
+    int32_t control_count;
+    int32_t time_count;
+    int32_t block_count;
+    int32_t path_count;
+    int32_t point_count;
+    uint64_t key;
+};
+
+static const char RACER_LUT_FILE_MAGIC[8] = {'R', 'R', 'T', 'R', 'C', 'L', 'U', 'T'};
+static const size_t FILE_ALIGNMENT = 64;
+
+static size_t align_offset(size_t offset) {
+    return (offset + FILE_ALIGNMENT - 1) / FILE_ALIGNMENT * FILE_ALIGNMENT;
+}
+
+ModelRacerLUT::ModelRacerLUT() { }
+
+ModelRacerLUT::~ModelRacerLUT() {
+    release();
+}
+
+void ModelRacerLUT::release() {
+    if (mapped_file != nullptr) {
+        munmap(mapped_file, mapped_size);
+        mapped_file = nullptr;
+    } else {
+        free(gases);
+        free(brakes);
+        free(steerings);
+        free(times);
+        free(slices);
+        free(block_table);
+        free(blocks);
+        free(paths);
+        free(points);
+    }
+    gases = brakes = steerings = times = nullptr;
+    slices = nullptr;
+    block_table = nullptr;
+    blocks = nullptr;
+    block_count = 0;
+    paths = nullptr;
+    path_count = 0;
+    points = nullptr;
+    point_count = 0;
+    slice_blocks.clear();
+    slice_paths.clear();
+    slice_points.clear();
+}
+
+//////////////////////////////////////////////  BUILDING  //////////////////////////////////////////////////
+
+// starts an empty table.  the control and time tables are copied.
+void ModelRacerLUT::configure(int _v_res, int _x_res, int _y_res, int _control_count, float *_gases, float *_brakes,
+                              float *_steerings, int _time_count, float *_times) {
+    release();
+    v_res = _v_res;
+    x_res = _x_res;
+    y_res = _y_res;
+    blocks_wide = (x_res + (1 << MODELRACERLUT_BLOCK_BITS) - 1) >> MODELRACERLUT_BLOCK_BITS;
+    blocks_high = (y_res + (1 << MODELRACERLUT_BLOCK_BITS) - 1) >> MODELRACERLUT_BLOCK_BITS;
+
+    control_count = _control_count;
+    gases = (float*)malloc(control_count * sizeof(float));
+    brakes = (float*)malloc(control_count * sizeof(float));
+    steerings = (float*)malloc(control_count * sizeof(float));
+    memcpy(gases, _gases, control_count * sizeof(float));
+    memcpy(brakes, _brakes, control_count * sizeof(float));
+    memcpy(steerings, _steerings, control_count * sizeof(float));
+    time_count = _time_count;
+    times = (float*)malloc(time_count * sizeof(float));
+    memcpy(times, _times, time_count * sizeof(float));
+
+    slices = (ModelRacerLUTSlice*)calloc(v_res, sizeof(ModelRacerLUTSlice));
+    block_table = (int32_t*)malloc((size_t)v_res * blocks_wide * blocks_high * sizeof(int32_t));
+    for (size_t i = 0; i < (size_t)v_res * blocks_wide * blocks_high; i++) {
+        block_table[i] = -1;
+    }
+    slice_blocks.resize(v_res);
+    slice_paths.resize(v_res);
+    slice_points.resize(v_res);
+}
+
+// stores one v0 slice, given as x_res * y_res cells with dforward major, and the paths of every control from each of
+// its initial velocities: point (x, y) of step s of a control from sample i is at trajectories[((i * control_count +
+// control) * time_count + s) * 2].  only the paths the cells use are kept, up to 65536 of them; cells on paths past
+// that are left out.  different slices can be packed from different threads at once.
+void ModelRacerLUT::packSlice(int v0idx, ModelRacerLUTCell *cells, int samples, float* trajectories) {
+    float vf_max = 0;
+    float hf_max = 0;
+    // the latest step each path is used to, -1 for paths no cell uses
+    std::vector<int32_t> path_steps((size_t)samples * control_count, -1);
+    for (size_t i = 0; i < (size_t)x_res * y_res; i++) {
+        if (cells[i].step == 0) continue;
+        vf_max = max(vf_max, cells[i].vf);
+        hf_max = max(hf_max, fabsf(cells[i].hf));
+        int32_t* path_step = &path_steps[(size_t)cells[i].sample * control_count + cells[i].control];
+        *path_step = max(*path_step, cells[i].step);
+    }
+    ModelRacerLUTSlice* slice = &slices[v0idx];
+    slice->vf_scale = vf_max > 0 ? vf_max / UINT16_MAX : 1;
+    slice->hf_scale = hf_max > 0 ? hf_max / INT16_MAX : 1;
+
+    // path_steps becomes each used path's index in the slice
+    std::vector<ModelRacerLUTPath>& stored_paths = slice_paths[v0idx];
+    std::vector<ModelRacerLUTPoint>& stored_points = slice_points[v0idx];
+    bool dropped = false;
+    for (size_t i = 0; i < path_steps.size(); i++) {
+        if (path_steps[i] < 0) continue;
+        if (stored_paths.size() > UINT16_MAX) {
+            path_steps[i] = -1;
+            dropped = true;
+            continue;
+        }
+        float* path_points = &trajectories[i * time_count * 2];
+        int count = path_steps[i] + 1;
+        float extent = 0;
+        for (int step = 0; step < count * 2; step++) {
+            extent = max(extent, fabsf(path_points[step]));
+        }
+        ModelRacerLUTPath path;
+        path.first = stored_points.size();
+        path.control = i % control_count;
+        path.count = count;
+        path.scale = extent > 0 ? extent / INT16_MAX : 1;
+        for (int step = 0; step < count; step++) {
+            ModelRacerLUTPoint point;
+            point.x = (int16_t)lrintf(minmax(path_points[step * 2] / path.scale, (float)-INT16_MAX, (float)INT16_MAX));
+            point.y = (int16_t)lrintf(minmax(path_points[step * 2 + 1] / path.scale, (float)-INT16_MAX, (float)INT16_MAX));
+            stored_points.push_back(point);
+        }
+        path_steps[i] = stored_paths.size();
+        stored_paths.push_back(path);
+    }
+    for (size_t i = 0; dropped && i < (size_t)x_res * y_res; i++) {
+        if (cells[i].step != 0 && path_steps[(size_t)cells[i].sample * control_count + cells[i].control] < 0) {
+            cells[i].step = 0;
+        }
+    }
+
+    std::vector<ModelRacerLUTEntry>& stored = slice_blocks[v0idx];
+    const int size = 1 << MODELRACERLUT_BLOCK_BITS;
+    for (int block_x = 0; block_x < blocks_wide; block_x++) {
+        for (int block_y = 0; block_y < blocks_high; block_y++) {
+            int x_end = min(x_res, (block_x + 1) * size);
+            int y_end = min(y_res, (block_y + 1) * size);
+            bool empty = true;
+            for (int x = block_x * size; x < x_end && empty; x++) {
+                for (int y = block_y * size; y < y_end; y++) {
+                    if (cells[(size_t)x * y_res + y].step != 0) {
+                        empty = false;
+                        break;
+                    }
+                }
+            }
+            if (empty) continue;
+
+            block_table[((size_t)v0idx * blocks_wide + block_x) * blocks_high + block_y] = stored.size() / MODELRACERLUT_BLOCK_CELLS;
+            size_t first = stored.size();
+            stored.resize(first + MODELRACERLUT_BLOCK_CELLS, ModelRacerLUTEntry{0, 0, 0, 0});
+            for (int x = block_x * size; x < x_end; x++) {
+                for (int y = block_y * size; y < y_end; y++) {
+                    ModelRacerLUTCell* cell = &cells[(size_t)x * y_res + y];
+                    if (cell->step == 0) continue;
+                    ModelRacerLUTEntry* entry = &stored[first + ((x - block_x * size) << MODELRACERLUT_BLOCK_BITS | (y - block_y * size))];
+                    entry->path = path_steps[(size_t)cell->sample * control_count + cell->control];
+                    entry->step = cell->step;
+                    entry->vf = (uint16_t)lrintf(minmax(cell->vf / slice->vf_scale, 0.0f, (float)UINT16_MAX));
+                    entry->hf = (int16_t)lrintf(minmax(cell->hf / slice->hf_scale, (float)-INT16_MAX, (float)INT16_MAX));
+                }
+            }
+        }
+    }
+}
+
+// joins the slices' blocks, paths and points into one array each
+void ModelRacerLUT::finish() {
+    size_t total = 0;
+    std::vector<int32_t> slice_first(v_res);
+    std::vector<uint32_t> slice_first_point(v_res);
+    for (int v0idx = 0; v0idx < v_res; v0idx++) {
+        slice_first[v0idx] = total / MODELRACERLUT_BLOCK_CELLS;
+        total += slice_blocks[v0idx].size();
+        slices[v0idx].first_path = path_count;
+        path_count += slice_paths[v0idx].size();
+        slice_first_point[v0idx] = point_count;
+        point_count += slice_points[v0idx].size();
+    }
+    block_count = total / MODELRACERLUT_BLOCK_CELLS;
+    blocks = (ModelRacerLUTEntry*)malloc((total > 0 ? total : 1) * sizeof(ModelRacerLUTEntry));
+    for (int v0idx = 0; v0idx < v_res; v0idx++) {
+        if (!slice_blocks[v0idx].empty()) {
+            memcpy(&blocks[(size_t)slice_first[v0idx] * MODELRACERLUT_BLOCK_CELLS], slice_blocks[v0idx].data(),
+                   slice_blocks[v0idx].size() * sizeof(ModelRacerLUTEntry));
+        }
+        int32_t* table = &block_table[(size_t)v0idx * blocks_wide * blocks_high];
+        for (int i = 0; i < blocks_wide * blocks_high; i++) {
+            if (table[i] >= 0) table[i] += slice_first[v0idx];
+        }
+    }
+
+    paths = (ModelRacerLUTPath*)malloc((path_count > 0 ? path_count : 1) * sizeof(ModelRacerLUTPath));
+    points = (ModelRacerLUTPoint*)malloc((point_count > 0 ? point_count : 1) * sizeof(ModelRacerLUTPoint));
+    for (int v0idx = 0; v0idx < v_res; v0idx++) {
+        ModelRacerLUTPath* slice_path = &paths[slices[v0idx].first_path];
+        for (size_t i = 0; i < slice_paths[v0idx].size(); i++) {
+            slice_path[i] = slice_paths[v0idx][i];
+            slice_path[i].first += slice_first_point[v0idx];
+        }
+        if (!slice_points[v0idx].empty()) {
+            memcpy(&points[slice_first_point[v0idx]], slice_points[v0idx].data(),
+                   slice_points[v0idx].size() * sizeof(ModelRacerLUTPoint));
+        }
+    }
+
+    slice_blocks.clear();
+    slice_blocks.shrink_to_fit();
+    slice_paths.clear();
+    slice_paths.shrink_to_fit();
+    slice_points.clear();
+    slice_points.shrink_to_fit();
+}
+
+size_t ModelRacerLUT::getMemorySize() {
+    return (3 * (size_t)control_count + time_count) * sizeof(float) + v_res * sizeof(ModelRacerLUTSlice)
+           + (size_t)v_res * blocks_wide * blocks_high * sizeof(int32_t)
+           + (size_t)block_count * MODELRACERLUT_BLOCK_CELLS * sizeof(ModelRacerLUTEntry)
+           + (size_t)path_count * sizeof(ModelRacerLUTPath) + (size_t)point_count * sizeof(ModelRacerLUTPoint);
+}
+
+//////////////////////////////////////////////  LUT FILES  ///////////////////////////////////////////////////
+
+// written under a temporary name and renamed into place, so other processes never map a partly written file.  the
+// file only saves time, so if writing fails it's just left out.
+void ModelRacerLUT::save(std::string filename, uint64_t key) {
+    std::string temporary = filename + ".tmp" + std::to_string(getpid());
+    FILE* fp = fopen(temporary.c_str(), "wb");
+    if (!fp) return;
+
+    ModelRacerLUTFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RACER_LUT_FILE_MAGIC, sizeof(header.magic));
+    header.version = RACER_LUT_FILE_VERSION;
+    header.v_res = v_res;
+    header.x_res = x_res;
+    header.y_res = y_res;
+    header.control_count = control_count;
+    header.time_count = time_count;
+    header.block_count = block_count;
+    header.path_count = path_count;
+    header.point_count = point_count;
+    header.key = key;
+
+    std::vector<std::pair<const void*, size_t>> arrays;
+    arrays.push_back(std::make_pair((const void*)gases, control_count * sizeof(float)));
+    arrays.push_back(std::make_pair((const void*)brakes, control_count * sizeof(float)));
+    arrays.push_back(std::make_pair((const void*)steerings, control_count * sizeof(float)));
+    arrays.push_back(std::make_pair((const void*)times, time_count * sizeof(float)));
+    arrays.push_back(std::make_pair((const void*)slices, v_res * sizeof(ModelRacerLUTSlice)));
+    arrays.push_back(std::make_pair((const void*)block_table, (size_t)v_res * blocks_wide * blocks_high * sizeof(int32_t)));
+    arrays.push_back(std::make_pair((const void*)blocks, (size_t)block_count * MODELRACERLUT_BLOCK_CELLS * sizeof(ModelRacerLUTEntry)));
+    arrays.push_back(std::make_pair((const void*)paths, (size_t)path_count * sizeof(ModelRacerLUTPath)));
+    arrays.push_back(std::make_pair((const void*)points, (size_t)point_count * sizeof(ModelRacerLUTPoint)));
+
+    static const char padding[FILE_ALIGNMENT] = {0};
+    size_t expected = sizeof(header);
+    size_t offset = fwrite(&header, 1, sizeof(header), fp);
+    for (std::pair<const void*, size_t>& array : arrays) {
+        expected = align_offset(expected) + array.second;
+        offset += fwrite(padding, 1, align_offset(offset) - offset, fp);
+        if (array.second > 0) {
+            offset += fwrite(array.first, 1, array.second, fp);
+        }
+    }
+    bool ok = fclose(fp) == 0 && offset == expected;
+    if (!ok || rename(temporary.c_str(), filename.c_str()) != 0) {
+        unlink(temporary.c_str());
+    }
+}
+
+// the arrays are used in place, from a read only private mapping of the file, so processes with the same table share
+// its pages.  false, leaving the table empty, if the file is missing, was saved with another key or by another
+// version, or is cut short.
+bool ModelRacerLUT::load(std::string filename, uint64_t key) {
+    release();
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || (size_t)sb.st_size < sizeof(ModelRacerLUTFileHeader)) {
+        close(fd);
+        return false;
+    }
+    size_t size = sb.st_size;
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    ModelRacerLUTFileHeader* header = (ModelRacerLUTFileHeader*)mapped;
+    if (memcmp(header->magic, RACER_LUT_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != RACER_LUT_FILE_VERSION || header->key != key) {
+        munmap(mapped, size);
+        return false;
+    }
+    int _blocks_wide = (header->x_res + (1 << MODELRACERLUT_BLOCK_BITS) - 1) >> MODELRACERLUT_BLOCK_BITS;
+    int _blocks_high = (header->y_res + (1 << MODELRACERLUT_BLOCK_BITS) - 1) >> MODELRACERLUT_BLOCK_BITS;
+    size_t sizes[9] = {header->control_count * sizeof(float), header->control_count * sizeof(float),
+                       header->control_count * sizeof(float), header->time_count * sizeof(float),
+                       header->v_res * sizeof(ModelRacerLUTSlice),
+                       (size_t)header->v_res * _blocks_wide * _blocks_high * sizeof(int32_t),
+                       (size_t)header->block_count * MODELRACERLUT_BLOCK_CELLS * sizeof(ModelRacerLUTEntry),
+                       (size_t)header->path_count * sizeof(ModelRacerLUTPath),
+                       (size_t)header->point_count * sizeof(ModelRacerLUTPoint)};
+    uint8_t* base = (uint8_t*)mapped;
+    uint8_t* arrays[9];
+    size_t offset = sizeof(ModelRacerLUTFileHeader);
+    for (int i = 0; i < 9; i++) {
+        offset = align_offset(offset);
+        arrays[i] = base + offset;
+        offset += sizes[i];
+    }
+    if (offset > size) {
+        munmap(mapped, size);
+        return false;
+    }
+
+    mapped_file = mapped;
+    mapped_size = size;
+    v_res = header->v_res;
+    x_res = header->x_res;
+    y_res = header->y_res;
+    blocks_wide = _blocks_wide;
+    blocks_high = _blocks_high;
+    control_count = header->control_count;
+    time_count = header->time_count;
+    block_count = header->block_count;
+    path_count = header->path_count;
+    point_count = header->point_count;
+    gases = (float*)arrays[0];
+    brakes = (float*)arrays[1];
+    steerings = (float*)arrays[2];
+    times = (float*)arrays[3];
+    slices = (ModelRacerLUTSlice*)arrays[4];
+    block_table = (int32_t*)arrays[5];
+    blocks = (ModelRacerLUTEntry*)arrays[6];
+    paths = (ModelRacerLUTPath*)arrays[7];
+    points = (ModelRacerLUTPoint*)arrays[8];
+    return true;
+}
@@ -0,0 +1,197 @@
+#ifndef RRT_MODELRACERLUT_H
+#define RRT_MODELRACERLUT_H
+
+#include "ModelRacerEdgeCost.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+
+#define MODELRACERLUT_BLOCK_BITS 4
+#define MODELRACERLUT_BLOCK_CELLS (1 << (2 * MODELRACERLUT_BLOCK_BITS))
+
+// LUTs saved by ModelRacerLUT::save() have this extension
+const std::string RACER_LUT_FILE_EXTENSION = ".racerlut";
+const uint32_t RACER_LUT_FILE_VERSION = 4;
+
+// one cell of the table, as the generator fills it in.  control and step index the tables given to configure(),
+// step 0 (no time taken) is an empty cell.  sample is which of the slice's initial velocities the cell was reached from.
+struct ModelRacerLUTCell {
+    int32_t sample;
+    int32_t control;
+    int32_t step;
+    float vf;
+    float hf;
+};
+
+// one cell of the table, as it's stored.  path indexes the paths of its v0 slice, which hold the control, and step
+// the times, so both come back exactly.  vf and hf are quantized to the range of their v0 slice.
+struct ModelRacerLUTEntry {
+    uint16_t path;
+    uint16_t step;
+    uint16_t vf;
+    int16_t hf;
+};
+
+// where the car goes under one control from one initial velocity, relative to where it starts facing +y: point i is
+// where it is at times[i + 1], so an entry at step s goes through points 0 to s.  points are kept up to the latest
+// step any entry uses, quantized to scale.
+struct ModelRacerLUTPath {
+    uint32_t first;
+    uint16_t control;
+    uint16_t count;
+    float scale;
+};
+
+struct ModelRacerLUTPoint {
+    int16_t x;
+    int16_t y;
+};
+
+struct ModelRacerLUTSlice {
+    float vf_scale;
+    float hf_scale;
+    int32_t first_path;
+};
+
+// The racer's state transition table: for each initial velocity slice, and each final position relative to the start,
+// the controls that get there and where they leave the car.  Most cells are empty, so the x-y plane of each slice is
+// split into blocks of 16x16 cells and only the blocks holding something are stored, 8 bytes a cell.  Each entry also
+// points at the path the car sweeps on the way, so edges can be checked for collisions without simulating them.
+
+class ModelRacerLUT {
+
+public:
+    ModelRacerLUT();
+    ~ModelRacerLUT();
+    // owns its arrays or the mapping of its cache file, so copies would free or unmap them twice
+    ModelRacerLUT(const ModelRacerLUT&) = delete;
+    ModelRacerLUT& operator=(const ModelRacerLUT&) = delete;
+    void configure(int _v_res, int _x_res, int _y_res, int _control_count, float* _gases, float* _brakes,
+                   float* _steerings, int _time_count, float* _times);
+    void packSlice(int v0idx, ModelRacerLUTCell* cells, int samples, float* trajectories);
+    void finish();
+
+    bool load(std::string filename, uint64_t key);
+    void save(std::string filename, uint64_t key);
+
+    // cells must be inside the table
+    inline bool get(int v0idx, int dforwardidx, int drightidx, ModelRacerEdgeCost* out) {
+        ModelRacerLUTEntry* found = entry(v0idx, dforwardidx, drightidx);
+        if (found == nullptr) return false;
+        decode(v0idx, found, out);
+        return true;
+    }
+
+    // dforward and dright are positions in the v0 slice in cells, so cell (i, j) covers [i, i + 1) x [j, j + 1).  the
+    // filled cells among the four whose centres surround the position are blended bilinearly: the controls and the time
+    // come from the one nearest, since those can't be mixed, and vf and hf are the weighted average of them all.
+    inline bool interpolate(int v0idx, float dforward, float dright, ModelRacerEdgeCost* out) {
+        float x = dforward - 0.5f;
+        float y = dright - 0.5f;
+        int x0 = (int)floorf(x);
+        int y0 = (int)floorf(y);
+        float wx = x - x0;
+        float wy = y - y0;
+        ModelRacerLUTEntry* corners[4];
+        float weights[4];
+        int nearest = -1;
+        for (int i = 0; i < 4; i++) {
+            int cx = x0 + (i >> 1);
+            int cy = y0 + (i & 1);
+            corners[i] = cx >= 0 && cx < x_res && cy >= 0 && cy < y_res ? entry(v0idx, cx, cy) : nullptr;
+            weights[i] = (i >> 1 ? wx : 1 - wx) * (i & 1 ? wy : 1 - wy);
+            if (corners[i] != nullptr && (nearest < 0 || weights[i] > weights[nearest])) nearest = i;
+        }
+        if (nearest < 0) return false;
+        decode(v0idx, corners[nearest], out);
+
+        // headings are blended as differences from the nearest one's, so they don't average across a wrap
+        float total = 0, vf = 0, dhf = 0;
+        for (int i = 0; i < 4; i++) {
+            if (corners[i] == nullptr) continue;
+            total += weights[i];
+            vf += weights[i] * corners[i]->vf * slices[v0idx].vf_scale;
+            dhf += weights[i] * remainderf(corners[i]->hf * slices[v0idx].hf_scale - out->hf, 2 * (float)M_PI);
+        }
+        if (total > 0) {
+            out->vf = vf / total;
+            out->hf += dhf / total;
+        }
+        return true;
+    }
+
+    // the path of an edge found by get() or interpolate(), as out->path_points points relative to its start
+    inline ModelRacerLUTPath* getPath(ModelRacerEdgeCost* found) { return &paths[found->path]; }
+    inline ModelRacerLUTPoint* getPathPoints(ModelRacerLUTPath* path) { return &points[path->first]; }
+
+    inline int getVRes() { return v_res; }
+    inline int getXRes() { return x_res; }
+    inline int getYRes() { return y_res; }
+    inline int getBlockCount() { return block_count; }
+    inline int getPathCount() { return path_count; }
+    inline int getPointCount() { return point_count; }
+    size_t getMemorySize();
+
+private:
+    void release();
+
+    inline ModelRacerLUTEntry* entry(int v0idx, int dforwardidx, int drightidx) {
+        const int mask = (1 << MODELRACERLUT_BLOCK_BITS) - 1;
+        int32_t block = block_table[(v0idx * blocks_wide + (dforwardidx >> MODELRACERLUT_BLOCK_BITS)) * blocks_high
+                                    + (drightidx >> MODELRACERLUT_BLOCK_BITS)];
+        if (block < 0) return nullptr;
+        ModelRacerLUTEntry* found = &blocks[(size_t)block * MODELRACERLUT_BLOCK_CELLS
+                                            + ((dforwardidx & mask) << MODELRACERLUT_BLOCK_BITS | (drightidx & mask))];
+        return found->step == 0 ? nullptr : found;
+    }
+
+    inline void decode(int v0idx, ModelRacerLUTEntry* found, ModelRacerEdgeCost* out) {
+        int path = slices[v0idx].first_path + found->path;
+        int control = paths[path].control;
+        out->cost = times[found->step]; // cost function is time
+        out->gas = gases[control];
+        out->brake = brakes[control];
+        out->steering = steerings[control];
+        out->dt = times[found->step];
+        out->vf = found->vf * slices[v0idx].vf_scale;
+        out->hf = found->hf * slices[v0idx].hf_scale;
+        out->path = path;
+        out->path_points = found->step + 1;
+    }
+
+    int v_res = 0;
+    int x_res = 0;
+    int y_res = 0;
+    int blocks_wide = 0;
+    int blocks_high = 0;
+
+    int control_count = 0;
+    float* gases = nullptr;
+    float* brakes = nullptr;
+    float* steerings = nullptr;
+    int time_count = 0;
+    float* times = nullptr;
+
+    ModelRacerLUTSlice* slices = nullptr;
+    // index of each block in blocks, -1 for empty blocks.  block (bx, by) of slice v is at (v * blocks_wide + bx) *
+    // blocks_high + by, and cell (x, y) of a block at x * 16 + y.
+    int32_t* block_table = nullptr;
+    ModelRacerLUTEntry* blocks = nullptr;
+    int block_count = 0;
+    ModelRacerLUTPath* paths = nullptr;
+    int path_count = 0;
+    ModelRacerLUTPoint* points = nullptr;
+    int point_count = 0;
+
+    // each slice's blocks, paths and points while the table is being built, numbered from 0 in the slice until finish()
+    std::vector<std::vector<ModelRacerLUTEntry>> slice_blocks;
+    std::vector<std::vector<ModelRacerLUTPath>> slice_paths;
+    std::vector<std::vector<ModelRacerLUTPoint>> slice_points;
+
+    // set when the arrays above point into a memory mapped file rather than their own allocations
+    void* mapped_file = nullptr;
+    size_t mapped_size = 0;
+};
+
+#endif //RRT_MODELRACERLUT_H
@@ -1,6 +1,11 @@
 #include "StateRacerMath.h"
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <vector>
+#include "utils.h"
 
 using namespace std;
 
@@ -28,6 +33,17 @@ void StateRacerMath::setSteps(int _V_STEPS, int _A_STEPS, int _S_STEPS, int _T_S
     T_STEPS = _T_STEPS;
 }
 
+void StateRacerMath::setThreads(int _threads) {
+    threads = _threads;
+}
+
+// LUTs are saved to the directory after they're generated, and loaded from it instead of being generated again when
+// the model and the LUT settings are the same
+void StateRacerMath::setLUTCache(std::string directory) {
+    lut_cache_directory = directory;
+    mkpath(lut_cache_directory.c_str(), S_IRWXU);
+}
+
 void StateRacerMath::setMap(MapRacer *_map) {
     map = _map;
     StateRacer _minimums, _maximums;
@@ -52,21 +68,26 @@ void StateRacerMath::setVis(std::string outputPath) {
 
 ////////////////////////////////////////// MODEL SIMULATION //////////////////////////////////////////////
 
-int StateRacerMath::lutindex(float v0, float dforwardf, float drightf) {
-    int v0idx = int(v0 / V_MAX * float(LUT_V_RES));
-    bool v0idx_ok = v0idx >= 0 && v0idx < LUT_V_RES;
+bool StateRacerMath::lutindex(float v0, float dforwardf, float drightf, int* v0idx, int* dforwardidx, int* drightidx) {
+    *v0idx = int(v0 / V_MAX * float(LUT_V_RES));
+    bool v0idx_ok = *v0idx >= 0 && *v0idx < LUT_V_RES;
 
-    int dforwardidx = int((dforwardf + X_MAX) / (2 * X_MAX) * float(LUT_X_RES));
-    bool dforwardidx_ok = dforwardidx >= 0 && dforwardidx < LUT_X_RES;
+    *dforwardidx = int((dforwardf + X_MAX) / (2 * X_MAX) * float(LUT_X_RES));
+    bool dforwardidx_ok = *dforwardidx >= 0 && *dforwardidx < LUT_X_RES;
 
-    int drightidx = int((drightf + Y_MAX) / (2 * Y_MAX) * float(LUT_Y_RES));
-    bool drightidx_ok = drightidx >= 0 && drightidx < LUT_Y_RES;
+    *drightidx = int((drightf + Y_MAX) / (2 * Y_MAX) * float(LUT_Y_RES));
+    bool drightidx_ok = *drightidx >= 0 && *drightidx < LUT_Y_RES;
 
-    int idx = v0idx * LUT_X_RES * LUT_Y_RES
-            + dforwardidx * LUT_Y_RES
-            + drightidx;
+    return v0idx_ok && dforwardidx_ok && drightidx_ok;
+}
 
-    return v0idx_ok && dforwardidx_ok && drightidx_ok ? idx : -1;
+// like lutindex(), but the position within the v0 slice is kept fractional, in cells, for interpolated lookups
+bool StateRacerMath::lutposition(float v0, float dforwardf, float drightf, int* v0idx, float* dforward, float* dright) {
+    *v0idx = int(v0 / V_MAX * float(LUT_V_RES));
+    *dforward = (dforwardf + X_MAX) / (2 * X_MAX) * float(LUT_X_RES);
+    *dright = (drightf + Y_MAX) / (2 * Y_MAX) * float(LUT_Y_RES);
+    return *v0idx >= 0 && *v0idx < LUT_V_RES && *dforward >= 0 && *dforward < LUT_X_RES && *dright >= 0 &&
+           *dright < LUT_Y_RES;
 }
 
 void StateRacerMath::generateStateTransitionLUT() {
@@ -76,45 +97,200 @@ void StateRacerMath::generateStateTransitionLUT() {
     // the table is time, position, and heading invariant, so it looks up data based on initial velocity and final relative position
     // when an entry is found, that entry will provide the final velocity and relative heading
 
-    delete [] lut;
-    lut = new ModelRacerEdgeCost[LUT_V_RES * LUT_X_RES * LUT_Y_RES]{0};
+    std::string cache_file = lut_cache_file();
+    if (!cache_file.empty() && lut.load(cache_file, lut_cache_key())) {
+        lut_speed = measure_lut_speed();
+        vis.renderLUT(&lut, V_MAX);
+        return;
+    }
 
+    // the inputs are stepped exactly as nested loops over them would step them, and each thread writes its entries in
+    // the order those loops would, so the table comes out the same for any number of threads
+    std::vector<float> velocities;
     for (float vi = 0; vi < V_MAX; vi += V_MAX / V_STEPS) {
-        for (float accel = -1; accel < 1; accel += 2.0f / A_STEPS) {
-            float gas = accel > 0 ? accel : 0;
-            float brake = accel < 0 ? -accel : 0;
-            for (float steering = -1; steering < 1; steering += 2.0f / S_STEPS) {
-                model->reset();
-                model->setInitialState(vi);
-                model->setControls(gas, brake, steering);
-                float dt = T_MAX / T_STEPS;
-                for (float t=0; t<T_MAX; t+= dt) {
-                    model->run(dt);
-                    StateRacer final;
-                    model->getState(&final);
-                    int idx = lutindex(vi, final.x, final.y);
-                    if (idx != -1) {
-                        ModelRacerEdgeCost *cost = &lut[idx];
-                        cost->brake = brake;
-                        cost->gas = gas;
-                        cost->steering = steering;
-                        cost->dt = t;
-                        cost->vf = final.v;
-                        cost->hf = final.h;
-                        cost->cost = t; // cost function is time
-
-                        // todo: figure out how to turn these points into outlines of solid sections, and paint in those sections
+        velocities.push_back(vi);
+    }
+    std::vector<float> gases, brakes, steerings;
+    for (float accel = -1; accel < 1; accel += 2.0f / A_STEPS) {
+        for (float steering = -1; steering < 1; steering += 2.0f / S_STEPS) {
+            gases.push_back(accel > 0 ? accel : 0);
+            brakes.push_back(accel < 0 ? -accel : 0);
+            steerings.push_back(steering);
+        }
+    }
+    float dt = T_MAX / T_STEPS;
+    std::vector<float> times;
+    for (float t=0; t<T_MAX; t+= dt) {
+        times.push_back(t);
+    }
+    int controls = (int)gases.size();
+    int steps = (int)times.size();
+    lut.configure(LUT_V_RES, LUT_X_RES, LUT_Y_RES, controls, gases.data(), brakes.data(), steerings.data(), steps,
+                  times.data());
+
+    // each thread owns a range of v0 slices of the table and simulates the initial velocities that fall in them, so no
+    // two threads write the same entry.  the controls are simulated MODELRACER_LANES at a time.  each slice is filled
+    // in full size, with the path of every control from every initial velocity in it, then packed.
+    size_t trajectory_size = (size_t)controls * steps * 2;
+    parallel_for(LUT_V_RES, 1, [&](int begin, int end) {
+        StateRacer* finals = (StateRacer*)malloc(MODELRACER_LANES * steps * sizeof(StateRacer));
+        ModelRacerLUTCell* cells = (ModelRacerLUTCell*)malloc((size_t)LUT_X_RES * LUT_Y_RES * sizeof(ModelRacerLUTCell));
+        float* trajectories = nullptr;
+        int trajectory_capacity = 0;
+        for (int slice = begin; slice < end; slice++) {
+            memset(cells, 0, (size_t)LUT_X_RES * LUT_Y_RES * sizeof(ModelRacerLUTCell));
+            int samples = 0;
+            for (float vi : velocities) {
+                if (int(vi / V_MAX * float(LUT_V_RES)) == slice) samples++;
+            }
+            if (samples > trajectory_capacity) {
+                trajectory_capacity = samples;
+                trajectories = (float*)realloc(trajectories, trajectory_capacity * trajectory_size * sizeof(float));
+            }
+            int sample = 0;
+            for (float vi : velocities) {
+                if (int(vi / V_MAX * float(LUT_V_RES)) != slice) continue;
+                simulate_lut_velocity(vi, sample, controls, gases.data(), brakes.data(), steerings.data(), steps, dt,
+                                      finals, cells, &trajectories[sample * trajectory_size]);
+                sample++;
+            }
+            fill_lut_holes(cells);
+            lut.packSlice(slice, cells, samples, trajectories);
+        }
+        free(trajectories);
+        free(cells);
+        free(finals);
+    }, threads);
+    lut.finish();
+
+    if (!cache_file.empty()) {
+        lut.save(cache_file, lut_cache_key());
+    }
+
+    lut_speed = measure_lut_speed();
+
+    // Visualize
+    vis.renderLUT(&lut, V_MAX);
+
+}
+
+// the fastest any edge covers ground, by the LUT's costs.  an edge gets the cost of a cell whose centre is within a
+// cell of it along each axis (see ModelRacerLUT::interpolate()), so each cell is measured at the far corner of that
+// range.
+float StateRacerMath::measure_lut_speed() {
+    float cell_x = 2 * X_MAX / LUT_X_RES;
+    float cell_y = 2 * Y_MAX / LUT_Y_RES;
+    float speed = 0;
+    ModelRacerEdgeCost entry;
+    for (int v0idx = 0; v0idx < LUT_V_RES; v0idx++) {
+        for (int dforwardidx = 0; dforwardidx < LUT_X_RES; dforwardidx++) {
+            float x = fmaxf(fabsf(-X_MAX + (dforwardidx - 0.5f) * cell_x), fabsf(-X_MAX + (dforwardidx + 1.5f) * cell_x));
+            for (int drightidx = 0; drightidx < LUT_Y_RES; drightidx++) {
+                if (!lut.get(v0idx, dforwardidx, drightidx, &entry)) continue;
+                float y = fmaxf(fabsf(-Y_MAX + (drightidx - 0.5f) * cell_y), fabsf(-Y_MAX + (drightidx + 1.5f) * cell_y));
+                speed = fmaxf(speed, hypotf(x, y) / entry.cost);
+            }
+        }
+    }
+    return speed;
+}
+
+// simulates every control from one initial velocity, MODELRACER_LANES at a time, and writes where each one is at every
+// step into cells, the v0 slice of the table holding vi, and into trajectories, as x-y pairs for each step of each
+// control.  sample numbers vi among the slice's initial velocities.  finals is scratch space for
+// MODELRACER_LANES * steps states.
+void StateRacerMath::simulate_lut_velocity(float vi, int sample, int controls, float* gases, float* brakes,
+                                           float* steerings, int steps, float dt, StateRacer* finals,
+                                           ModelRacerLUTCell* cells, float* trajectories) {
+    for (int first = 0; first < controls; first += MODELRACER_LANES) {
+        int count = min(controls - first, MODELRACER_LANES);
+        ModelRacerLanes lanes;
+        for (int lane = 0; lane < MODELRACER_LANES; lane++) {
+            int control = first + (lane < count ? lane : 0);
+            lanes.x[lane] = 0;
+            lanes.y[lane] = 0;
+            lanes.v[lane] = vi;
+            lanes.h[lane] = 0;
+            lanes.gas[lane] = gases[control];
+            lanes.brake[lane] = brakes[control];
+            lanes.steering[lane] = steerings[control];
+        }
+        for (int step = 0; step < steps; step++) {
+            model->runLanes(&lanes, dt);
+            for (int lane = 0; lane < count; lane++) {
+                finals[lane * steps + step].set(lanes.x[lane], lanes.y[lane], lanes.v[lane], lanes.h[lane]);
+                float* point = &trajectories[((size_t)(first + lane) * steps + step) * 2];
+                point[0] = lanes.x[lane];
+                point[1] = lanes.y[lane];
+            }
+        }
+        for (int lane = 0; lane < count; lane++) {
+            for (int step = 0; step < steps; step++) {
+                StateRacer* final = &finals[lane * steps + step];
+                int v0idx, dforwardidx, drightidx;
+                if (step == 0 || !lutindex(vi, final->x, final->y, &v0idx, &dforwardidx, &drightidx)) continue;
+                // the cost is the time, so the cheapest way into a cell is the one with the earliest step.  ties go to
+                // the first control, which is the same for any number of threads.
+                ModelRacerLUTCell *cell = &cells[(size_t)dforwardidx * LUT_Y_RES + drightidx];
+                if (cell->step != 0 && cell->step <= step) continue;
+                cell->sample = sample;
+                cell->control = first + lane;
+                cell->step = step;
+                cell->vf = final->v;
+                cell->hf = final->h;
+            }
+        }
+    }
+}
+
+// the endpoints of neighbouring controls leave empty cells between them inside the reachable region.  an empty cell
+// with filled cells on both sides of it, along its row or its column and within LUT_FILL_RADIUS, takes the entry of the
+// nearer one (the cheaper one when they're as near).  rows are filled first, then columns, so holes that are open along
+// both get filled from both.  cells beyond the edge of the region have nothing on one side and stay empty.
+void StateRacerMath::fill_lut_holes(ModelRacerLUTCell *cells) {
+    for (int pass = 0; pass < 2; pass++) {
+        int lines = pass == 0 ? LUT_X_RES : LUT_Y_RES;
+        int length = pass == 0 ? LUT_Y_RES : LUT_X_RES;
+        size_t line_stride = pass == 0 ? LUT_Y_RES : 1;
+        size_t stride = pass == 0 ? 1 : LUT_Y_RES;
+        for (int line = 0; line < lines; line++) {
+            ModelRacerLUTCell* first = &cells[line * line_stride];
+            int previous = -1;
+            for (int i = 0; i < length; i++) {
+                if (first[i * stride].step == 0) continue;
+                int gap = i - previous - 1;
+                if (previous >= 0 && gap > 0 && gap <= LUT_FILL_RADIUS) {
+                    ModelRacerLUTCell* before = &first[previous * stride];
+                    ModelRacerLUTCell* after = &first[i * stride];
+                    for (int j = previous + 1; j < i; j++) {
+                        int to_before = j - previous;
+                        int to_after = i - j;
+                        bool use_before = to_before < to_after || (to_before == to_after && before->step <= after->step);
+                        first[j * stride] = use_before ? *before : *after;
                     }
                 }
+                previous = i;
             }
         }
     }
+}
 
-    // todo: fill in gaps in the table???
+//////////////////////////////////////////////  LUT CACHE  ///////////////////////////////////////////////
 
-    // Visualize
-    vis.renderLUT(lut, LUT_V_RES, LUT_X_RES, LUT_Y_RES, V_MAX);
+// everything the table is made from
+uint64_t StateRacerMath::lut_cache_key() {
+    float settings[] = {model->gas_strength, model->brake_strength, model->steering_strength, model->steering_friction,
+                        model->air_strength, model->dt_internal, V_MAX, T_MAX, X_MAX, Y_MAX};
+    int32_t counts[] = {LUT_V_RES, LUT_X_RES, LUT_Y_RES, V_STEPS, A_STEPS, S_STEPS, T_STEPS};
+    uint64_t hash = fnv1a_64(settings, sizeof(settings));
+    return fnv1a_64(counts, sizeof(counts), hash);
+}
 
+std::string StateRacerMath::lut_cache_file() {
+    if (lut_cache_directory.empty()) return "";
+    char name[32];
+    snprintf(name, sizeof(name), "lut_%016llx", (unsigned long long)lut_cache_key());
+    return lut_cache_directory + name + RACER_LUT_FILE_EXTENSION;
 }
 
 ////////////////////////////////////////  OBSTACLE DETECTION  ////////////////////////////////////////////
@@ -127,28 +303,30 @@ bool StateRacerMath::edgeInObstacle(StateRacer *source, StateRacer *dest) {
 
     if (source == dest) return false;
 
-    int dist = max(2, int(hypotf(dest->x - source->x, dest->y - source->y) * EDGE_WALK_SCALE));
-    StateRacer* points = (StateRacer*)malloc(sizeof(StateRacer) * dist);
-    bool path_found = edgePath(source, dest, points, dist);
+    ModelRacerEdgeCost obj;
+    if (!edgeCostObj(source, dest, &obj)) return true;
 
-    if (!path_found) return true;
+    return path_in_obstacle(source, &obj);
+}
 
-    bool found = false;
-    for (int i=0; i<dist; i++) {
-        if (pointInObstacle(&points[i])) {
-            found = true;
-            break;
-        }
+// walks the path the LUT stored for the edge, turned to the source's heading and moved to its position
+bool StateRacerMath::path_in_obstacle(StateRacer *source, ModelRacerEdgeCost *obj) {
+    ModelRacerLUTPath* path = lut.getPath(obj);
+    ModelRacerLUTPoint* points = lut.getPathPoints(path);
+    double sin_h = sin(source->h) * path->scale;
+    double cos_h = cos(source->h) * path->scale;
+    for (int i = 0; i < obj->path_points; i++) {
+        double x = source->x + points[i].x * cos_h + points[i].y * sin_h;
+        double y = source->y - points[i].x * sin_h + points[i].y * cos_h;
+        if (map->getPixelIsObstacle(x, y)) return true;
     }
-
-    free(points);
-
-    return found;
+    return false;
 }
 
 /////////////////////////////////////////  COST CALCULATIONS  ////////////////////////////////////////////
 
-ModelRacerEdgeCost* StateRacerMath::edgeCostObj(StateRacer *source, StateRacer *dest) {
+// fills in out and returns true if the LUT has an entry for the edge
+bool StateRacerMath::edgeCostObj(StateRacer *source, StateRacer *dest, ModelRacerEdgeCost *out) {
     // tranform this segment so that it's origin is (0, 0) and its initial heading is 0
     // then look up the segment in the LUT
 
@@ -163,41 +341,70 @@ ModelRacerEdgeCost* StateRacerMath::edgeCostObj(StateRacer *source, StateRacer *
     dest_relative_to_origin.x = dist * sin(dHeading);
     dest_relative_to_origin.y = dist * cos(dHeading);
 
-    int idx = lutindex(source->v, dest_relative_to_origin.x, dest_relative_to_origin.y);
-
-    if (idx == -1) return nullptr;
-    if (lut[idx].cost == 0) return nullptr;
-    return &lut[idx];
+    int v0idx;
+    float dforward, dright;
+    if (!lutposition(source->v, dest_relative_to_origin.x, dest_relative_to_origin.y, &v0idx, &dforward, &dright)) return false;
+    return lut.interpolate(v0idx, dforward, dright, out);
 }
 
 float StateRacerMath::edgeCost(StateRacer *source, StateRacer *dest, StateRacer *dest_updated) {
-    ModelRacerEdgeCost* obj = edgeCostObj(source, dest);
+    ModelRacerEdgeCost obj;
     float output = INFINITY;
-    if (obj) {
+    if (edgeCostObj(source, dest, &obj)) {
         float heading = atan2f(dest->x - source->x, dest->y - source->y);
-        output= obj->cost;
+        output= obj.cost;
         if (dest_updated != nullptr) {
             *dest_updated = *dest;
-            dest_updated->v = obj->vf;
-            dest_updated->h = obj->hf + heading;
+            dest_updated->v = obj.vf;
+            dest_updated->h = obj.hf + heading;
         }
     }
     return output;
 }
 
+// one LUT lookup, shared by the cost and the collision check
+EdgeEvaluation<StateRacer> StateRacerMath::evaluateEdge(StateRacer *source, StateRacer *dest) {
+    EdgeEvaluation<StateRacer> result;
+    result.collides = true;
+    result.cost = INFINITY;
+    result.dest = *dest;
+    ModelRacerEdgeCost obj;
+    if (!edgeCostObj(source, dest, &obj)) return result;
+    if (path_in_obstacle(source, &obj)) return result;
+    float heading = atan2f(dest->x - source->x, dest->y - source->y);
+    result.collides = false;
+    result.cost = obj.cost;
+    result.dest.v = obj.vf;
+    result.dest.h = obj.hf + heading;
+    return result;
+}
+
+// pointCount points along the path the LUT stored for the edge, the same one path_in_obstacle() checks.  the stored
+// points are evenly spaced in time, so they're spread over those, with v and h eased from the source's to the edge's end.
 bool StateRacerMath::edgePath(StateRacer *source, StateRacer *dest, StateRacer p[], int pointCount) {
-    ModelRacerEdgeCost* obj = edgeCostObj(source, dest);
-    if (obj) {
-        model->reset();
-        model->setInitialState(source);
-        model->setControls(obj->gas, obj->brake, obj->steering);
-        float dt = obj->cost / float(pointCount);
-        for (int i = 0; i < pointCount; i++) {
-            model->run(dt);
-            model->getState(&p[i]);
-        }
+    ModelRacerEdgeCost obj;
+    if (!edgeCostObj(source, dest, &obj)) return false;
+    ModelRacerLUTPath* path = lut.getPath(&obj);
+    ModelRacerLUTPoint* points = lut.getPathPoints(path);
+    double sin_h = sin(source->h) * path->scale;
+    double cos_h = cos(source->h) * path->scale;
+    float hf = obj.hf + atan2f(dest->x - source->x, dest->y - source->y);
+    for (int i = 0; i < pointCount; i++) {
+        // position -1 is the source itself, which isn't stored
+        float position = float(i + 1) / pointCount * obj.path_points - 1;
+        int index = min((int)floorf(position), obj.path_points - 2);
+        float fraction = position - index;
+        double x0 = index < 0 ? 0 : points[index].x;
+        double y0 = index < 0 ? 0 : points[index].y;
+        double rx = x0 + (points[index + 1].x - x0) * fraction;
+        double ry = y0 + (points[index + 1].y - y0) * fraction;
+        float progress = float(i + 1) / pointCount;
+        p[i].set(source->x + rx * cos_h + ry * sin_h,
+                 source->y - rx * sin_h + ry * cos_h,
+                 source->v + (obj.vf - source->v) * progress,
+                 source->h + (hf - source->h) * progress);
     }
-    return obj != nullptr;
+    return true;
 }
 
 ///////////////////////////////////////  DISTANCE CALCULATIONS  //////////////////////////////////////////
@@ -216,6 +423,12 @@ double StateRacerMath::approx_distance(StateRacer *source, StateRacer *dest) {
     return fabs(dest->x - source->x) + fabs(dest->y - source->y);
 }
 
+// admissible estimate of the cost from source to dest: the distance at the fastest speed any LUT edge manages.  no
+// edge covers more ground than that for its cost, so no path does either.
+float StateRacerMath::costToGo(StateRacer *source, StateRacer *dest) {
+    return lut_speed > 0 ? hypotf(dest->x - source->x, dest->y - source->y) / lut_speed : 0;
+}
+
 ////////////////////////////////////////// SAMPLE GENERATION /////////////////////////////////////////////
 
 void StateRacerMath::setRandomStateConstraints(StateRacer _minimums, StateRacer _maximums) {
@@ -233,13 +446,17 @@ void StateRacerMath::setRandomStateConstraints(StateRacer _minimums, StateRacer
     shift.h = -M_PI;
 }
 
+void StateRacerMath::setRandomSeed(unsigned int seed) {
+    random_seed = seed;
+}
+
 StateRacer StateRacerMath::getRandomState() {
     StateRacer output;
-    output.x = (double)rand() * scale.x + shift.x;
-    output.y = (double)rand() * scale.y + shift.y;
+    output.x = (double)rand_r(&random_seed) * scale.x + shift.x;
+    output.y = (double)rand_r(&random_seed) * scale.y + shift.y;
     // V and H aren't generated for the sample, because our algorithm here is to generate x-y samples and then if they can be connected to a node by any V/H settings, use those
-    //output.v = (double)rand() * scale.v + shift.v;
-    //output.h = (double)rand() * scale.h + shift.h;
+    //output.v = (double)rand_r(&random_seed) * scale.v + shift.v;
+    //output.h = (double)rand_r(&random_seed) * scale.h + shift.h;
     output.v = 0;
     output.h = 0;
     return output;
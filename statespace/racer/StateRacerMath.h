@@ -5,8 +5,11 @@
 #include "MapRacer.h"
 #include "ModelRacer.h"
 #include "ModelRacerEdgeCost.h"
+#include "ModelRacerLUT.h"
+#include "EdgeEvaluation.h"
 #include "StateRacerMathVis.h"
 #include <string>
+#include <cstdint>
 
 // Racer is a top-down racing game solver, where the car can accelerate, brake, coast, go straight or left or right.
 
@@ -21,6 +24,8 @@ public:
     void setMax(float _V_MAX, float _T_MAX, float _X_MAX, float _Y_MAX);
     void setRes(int _LUT_V_RES, int _LUT_X_RES, int _LUT_Y_RES);
     void setSteps(int _V_STEPS, int _A_STEPS, int _S_STEPS, int _T_STEPS);
+    void setThreads(int _threads);
+    void setLUTCache(std::string directory);
 
     void setModel(ModelRacer* _model);
 
@@ -29,26 +34,40 @@ public:
     bool pointInObstacle(StateRacer* point);
     bool edgeInObstacle(StateRacer* source, StateRacer* dest);
 
-    ModelRacerEdgeCost* edgeCostObj(StateRacer* source, StateRacer* dest);
+    bool edgeCostObj(StateRacer* source, StateRacer* dest, ModelRacerEdgeCost* out);
     float edgeCost(StateRacer* source, StateRacer* dest, StateRacer* dest_updated=nullptr);
+    EdgeEvaluation<StateRacer> evaluateEdge(StateRacer* source, StateRacer* dest);
 
     bool edgePath(StateRacer *source, StateRacer *dest, StateRacer p[], int pointCount);
 
     double distance(StateRacer* source, StateRacer* dest);
     double approx_distance(StateRacer* source, StateRacer* dest);
+    float costToGo(StateRacer* source, StateRacer* dest);
 
     void setRandomStateConstraints(StateRacer _minimums, StateRacer _maximums);
+    void setRandomSeed(unsigned int seed);
     StateRacer getRandomState();
 
-    int lutindex(float v0, float dforwardf, float drightf);
+    bool lutindex(float v0, float dforwardf, float drightf, int* v0idx, int* dforwardidx, int* drightidx);
+    bool lutposition(float v0, float dforwardf, float drightf, int* v0idx, float* dforward, float* dright);
 
 protected:
     void generateStateTransitionLUT();
+    void simulate_lut_velocity(float vi, int sample, int controls, float* gases, float* brakes, float* steerings,
+                               int steps, float dt, StateRacer* finals, ModelRacerLUTCell* cells, float* trajectories);
+    void fill_lut_holes(ModelRacerLUTCell* cells);
+    float measure_lut_speed();
+    bool path_in_obstacle(StateRacer* source, ModelRacerEdgeCost* obj);
+
+    uint64_t lut_cache_key();
+    std::string lut_cache_file();
 
     StateRacer minimums, maximums;
     StateRacer scale, shift;
+    unsigned int random_seed = 1;
 
-    const float EDGE_WALK_SCALE = 0.1f;
+    // widest gap between filled LUT cells that's filled in, in cells
+    const int LUT_FILL_RADIUS = 4;
 
     MapRacer* map = nullptr;
     ModelRacer* model = nullptr;
@@ -67,7 +86,15 @@ protected:
     int S_STEPS = 100;
     int T_STEPS = 100;
 
-    ModelRacerEdgeCost* lut = nullptr;
+    // threads generating the LUT, 0 for one per hardware thread
+    int threads = 0;
+
+    ModelRacerLUT lut;
+    // distance over cost, at most, for any edge the LUT gives.  0 until there's a LUT.
+    float lut_speed = 0;
+
+    // empty for no cache
+    std::string lut_cache_directory = "";
 
     StateRacerMathVis vis;
 };
@@ -8,24 +8,12 @@ void StateRacerMathVis::setOutputPath(std::string _outputPath) {
     configured = true;
 }
 
-int StateRacerMathVis::lutindex(int v0idx, int dforwardidx, int drightidx) {
-    bool v0idx_ok = v0idx >= 0 && v0idx < vres;
-    bool dforwardidx_ok = dforwardidx >= 0 && dforwardidx < xres;
-    bool drightidx_ok = drightidx >= 0 && drightidx < yres;
-
-    int idx = v0idx * xres * yres
-              + dforwardidx * yres
-              + drightidx;
-
-    return v0idx_ok && dforwardidx_ok && drightidx_ok ? idx : -1;
-}
-
-void StateRacerMathVis::renderLUT(ModelRacerEdgeCost *lut, int _vres, int _xres, int _yres, float _vmax) {
+void StateRacerMathVis::renderLUT(ModelRacerLUT *lut, float _vmax) {
     if (!configured) return;
 
-    vres = _vres;
-    xres = _xres;
-    yres = _yres;
+    vres = lut->getVRes();
+    xres = lut->getXRes();
+    yres = lut->getYRes();
     vmax = _vmax;
 
     // allocate memory for the image
@@ -36,8 +24,13 @@ void StateRacerMathVis::renderLUT(ModelRacerEdgeCost *lut, int _vres, int _xres,
 
     // find the max cost anywhere in the data
     float max_cost = 0;
-    for (int i=0; i<vres*xres*yres; i++) {
-        if (lut[i].cost > max_cost) max_cost = lut[i].cost;
+    ModelRacerEdgeCost entry;
+    for (int v0idx=0; v0idx < vres; v0idx++) {
+        for (int dforwardidx = 0; dforwardidx < xres; dforwardidx++) {
+            for (int drightidx = 0; drightidx < yres; drightidx++) {
+                if (lut->get(v0idx, dforwardidx, drightidx, &entry) && entry.cost > max_cost) max_cost = entry.cost;
+            }
+        }
     }
 
     // for each v0
@@ -46,7 +39,7 @@ void StateRacerMathVis::renderLUT(ModelRacerEdgeCost *lut, int _vres, int _xres,
         // paint the x-y picture
         for (int dforwardidx = 0; dforwardidx < xres; dforwardidx++) {
             for (int drightidx = 0; drightidx < yres; drightidx++) {
-                float cost = lut[lutindex(v0idx, dforwardidx, drightidx)].cost;
+                float cost = lut->get(v0idx, dforwardidx, drightidx, &entry) ? entry.cost : 0;
                 png_bytep row = vis_rows[yres - drightidx - 1];
                 if (cost > 0) {
                     int value = cost / max_cost * 255;
@@ -1,7 +1,7 @@
 #ifndef RRT_STATERACERMATHVIS_H
 #define RRT_STATERACERMATHVIS_H
 
-#include "ModelRacerEdgeCost.h"
+#include "ModelRacerLUT.h"
 #include <string>
 #include <png.h>
 
@@ -11,11 +11,10 @@ class StateRacerMathVis {
 
 public:
     void setOutputPath(std::string _outputPath);
-    void renderLUT(ModelRacerEdgeCost lut[], int vres, int xres, int yres, float vmax);
+    void renderLUT(ModelRacerLUT* lut, float vmax);
 
 private:
     void write_png(std::string filename_prefix);
-    int lutindex(int v0idx, int dforwardidx, int drightidx);
 
     std::string outputPath = "";
     bool configured = false;
@@ -2,6 +2,9 @@
 
 #include <cstring>
 #include <cerrno>
+#include <cmath>
+#include <thread>
+#include <vector>
 #include <libgen.h>
 
 int mkpath(const char* dir, mode_t mode) {
@@ -25,4 +28,55 @@ int mkpath(const char* dir, mode_t mode) {
     return mkdir(dir, mode);
 #endif
 
-}
\ No newline at end of file
+}
+
+// pass a previous result as hash to continue hashing across several buffers
+uint64_t fnv1a_64(const void* data, size_t size, uint64_t hash) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// splits [0, count) into one range per thread and runs work on each.  ranges start on multiples of align, for work
+// that writes into the 8x8 tiles of an OccupancyBitmap.  threads 0 means one per hardware thread.
+void parallel_for(int count, int align, std::function<void(int, int)> work, int threads) {
+    if (threads < 1) threads = std::thread::hardware_concurrency();
+    if (threads < 1) threads = 1;
+    int chunk = (count + threads - 1) / threads;
+    chunk = (chunk + align - 1) / align * align;
+    std::vector<std::thread> workers;
+    for (int begin = 0; begin < count; begin += chunk) {
+        workers.push_back(std::thread(work, begin, begin + chunk < count ? begin + chunk : count));
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+// squared distance transform of a sampled function, in one dimension.  (Felzenszwalb & Huttenlocher)
+// f holds n samples, d receives the result.  v and z are scratch space of n and n+1 entries.
+void distance_transform_1d(float* f, int n, float* d, int* v, float* z) {
+    int k = 0;
+    v[0] = 0;
+    z[0] = -INFINITY;
+    z[1] = INFINITY;
+    for (int q = 1; q < n; q++) {
+        float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+        while (s <= z[k]) {
+            k--;
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k+1] = INFINITY;
+    }
+    k = 0;
+    for (int q = 0; q < n; q++) {
+        while (z[k+1] < q) k++;
+        d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+    }
+}
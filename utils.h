@@ -3,9 +3,18 @@
 
 #include <sys/stat.h>
 #include <string>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
 
 int mkpath(const char* file_path, mode_t mode);
 
+const uint64_t FNV1A_64_OFFSET = 0xcbf29ce484222325ULL;
+uint64_t fnv1a_64(const void* data, size_t size, uint64_t hash=FNV1A_64_OFFSET);
+
+void parallel_for(int count, int align, std::function<void(int, int)> work, int threads=0);
+void distance_transform_1d(float* f, int n, float* d, int* v, float* z);
+
 inline int min(int a, int b) { return (a < b) ? a : b; }
 inline float min(float a, float b) { return (a < b) ? a : b; }
 inline double min(double a, double b) { return (a < b) ? a : b; }